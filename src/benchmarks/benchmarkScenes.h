@@ -0,0 +1,267 @@
+#pragma once
+
+/// \file benchmarks/benchmarkScenes.h
+///
+/// Fixed-seed reproductions of the chapter scenes, and camera ray generation matching the chapter programs.
+
+#include <gm/functions/length.h>
+#include <gm/functions/normalize.h>
+#include <gm/types/floatRange.h>
+#include <gm/types/vec2i.h>
+#include <gm/types/vec3f.h>
+
+#include <raytrace/bvh.h>
+#include <raytrace/camera.h>
+#include <raytrace/cameraRayGenerator.h>
+#include <raytrace/dielectric.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/lambert.h>
+#include <raytrace/metal.h>
+#include <raytrace/pathTracer.h>
+#include <raytrace/randomNumberGenerator.h>
+#include <raytrace/ray.h>
+#include <raytrace/sphere.h>
+#include <raytrace/sphereSet.h>
+#include <raytrace/wideBVH.h>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+
+/// \var c_benchmarkSeed
+///
+/// Seed used for scene generation and sampling, such that every run traces the exact same rays.
+constexpr uint32_t c_benchmarkSeed = 0;
+
+/// \var c_magnitudeRange
+///
+/// Ray magnitude range for scene intersection, culling hits which are too near ("Shadow acne").
+constexpr gm::FloatRange c_magnitudeRange( 0.001f, std::numeric_limits< float >::max() );
+
+/// \class BenchmarkScene
+///
+/// A camera and the scene objects it views.
+class BenchmarkScene final
+{
+public:
+    inline explicit BenchmarkScene( const std::string& i_name, const raytrace::Camera& i_camera )
+        : m_name( i_name )
+        , m_camera( i_camera )
+    {
+    }
+
+    std::string              m_name;
+    raytrace::Camera         m_camera;
+    raytrace::SceneObjectPtr m_sceneObject;
+};
+
+/// Add the spheres shared by the scenes of chapters 7 through 9.
+///
+/// \param o_sceneObjects The collection to add spheres into.
+inline void AddDielectricSpheres( raytrace::SceneObjectPtrs& o_sceneObjects )
+{
+    // Lambert sphere.
+    o_sceneObjects.push_back( std::make_unique< raytrace::Sphere >(
+        gm::Vec3f( 0.0f, 0.0f, -1.0f ),
+        0.5,
+        std::make_shared< raytrace::Lambert >( /* albedo */ gm::Vec3f( 0.7f, 0.3f, 0.3f ) ) ) );
+
+    // Ground plane (also lambert).
+    o_sceneObjects.push_back( std::make_unique< raytrace::Sphere >(
+        gm::Vec3f( 0.0f, -100.5, -1.0f ),
+        100,
+        std::make_shared< raytrace::Lambert >( /* albedo */ gm::Vec3f( 0.8f, 0.8f, 0.0f ) ) ) );
+
+    // Reflective metal sphere, with some fuzziness.
+    o_sceneObjects.push_back( std::make_unique< raytrace::Sphere >(
+        gm::Vec3f( 1.0f, 0.0f, -1.0f ),
+        0.5,
+        std::make_shared< raytrace::Metal >( /* albedo */ gm::Vec3f( 0.8f, 0.6f, 0.2f ), /* fuzziness */ 0.02 ) ) );
+
+    // Refractive dielectric spheres.
+    o_sceneObjects.push_back( std::make_unique< raytrace::Sphere >(
+        gm::Vec3f( -1.0f, 0.0f, -1.0f ),
+        0.5,
+        std::make_shared< raytrace::Dielectric >( /* refractiveIndex = glass */ 1.5 ) ) );
+    o_sceneObjects.push_back( std::make_unique< raytrace::Sphere >(
+        gm::Vec3f( -1.0f, 0.0f, -1.0f ),
+        -0.45,
+        std::make_shared< raytrace::Dielectric >( /* refractiveIndex = glass */ 1.5 ) ) );
+}
+
+/// Create the scene of 7_dielectrics.
+inline BenchmarkScene CreateDielectricsScene( float i_aspectRatio )
+{
+    BenchmarkScene scene( "7_dielectrics",
+                          raytrace::Camera( gm::Vec3f( 0, 0, 0 ),
+                                            gm::Vec3f( 0, 0, -1 ),
+                                            gm::Vec3f( 0, 1, 0 ),
+                                            /* verticalFov */ 90.0f,
+                                            i_aspectRatio ) );
+
+    raytrace::SceneObjectPtrs sceneObjects;
+    AddDielectricSpheres( sceneObjects );
+    scene.m_sceneObject = std::make_unique< raytrace::BVH >( std::move( sceneObjects ) );
+    return scene;
+}
+
+/// Create the scene of 8_positionableCamera.
+inline BenchmarkScene CreatePositionableCameraScene( float i_aspectRatio )
+{
+    BenchmarkScene scene( "8_positionableCamera",
+                          raytrace::Camera( gm::Vec3f( -2, 1.5, 1 ),
+                                            gm::Vec3f( 0, 0, -1 ),
+                                            gm::Vec3f( 0, 1, 0 ),
+                                            /* verticalFov */ 45.0f,
+                                            i_aspectRatio ) );
+
+    raytrace::SceneObjectPtrs sceneObjects;
+    AddDielectricSpheres( sceneObjects );
+    scene.m_sceneObject = std::make_unique< raytrace::BVH >( std::move( sceneObjects ) );
+    return scene;
+}
+
+/// Create the scene of 9_defocusBlur.
+inline BenchmarkScene CreateDefocusBlurScene( float i_aspectRatio )
+{
+    const gm::Vec3f origin( 3, 3, 2 );
+    const gm::Vec3f lookAt( 0, 0, -1 );
+    BenchmarkScene  scene( "9_defocusBlur",
+                          raytrace::Camera( origin,
+                                            lookAt,
+                                            gm::Vec3f( 0, 1, 0 ),
+                                            /* verticalFov */ 20.0f,
+                                            i_aspectRatio,
+                                            /* aperture */ 2.0f,
+                                            /* focalDistance */ gm::Length( lookAt - origin ) ) );
+
+    raytrace::SceneObjectPtrs sceneObjects;
+    AddDielectricSpheres( sceneObjects );
+    scene.m_sceneObject = std::make_unique< raytrace::BVH >( std::move( sceneObjects ) );
+    return scene;
+}
+
+/// Generate the random sphere field of 10_whereNext, drawing from a fixed-seed generator rather than the global
+/// random number generator.
+///
+/// \tparam AddSphereFnT Callable with the signature void( const gm::Vec3f&, float, const MaterialSharedPtr& ).
+template < typename AddSphereFnT >
+inline void PopulateWhereNextScene( const AddSphereFnT& i_addSphere )
+{
+    raytrace::RandomNumberGenerator rng( 0, 0, c_benchmarkSeed );
+
+    raytrace::MaterialSharedPtr groundMaterial = std::make_shared< raytrace::Lambert >( gm::Vec3f( 0.5, 0.5, 0.5 ) );
+    i_addSphere( gm::Vec3f( 0, -1000, 0 ), 1000, groundMaterial );
+
+    for ( int a = -11; a < 11; a++ )
+    {
+        for ( int b = -11; b < 11; b++ )
+        {
+            gm::Vec3f center( a + 0.9f * rng.NextFloat(), 0.2f, b + 0.9f * rng.NextFloat() );
+            if ( gm::Length( center - gm::Vec3f( 4, 0.2, 0 ) ) <= 0.9f )
+            {
+                continue;
+            }
+
+            float materialChoice = rng.NextFloat();
+            if ( materialChoice < 0.8f )
+            {
+                gm::Vec3f albedo( rng.NextFloat(), rng.NextFloat(), rng.NextFloat() );
+                i_addSphere( center, 0.2f, std::make_shared< raytrace::Lambert >( albedo ) );
+            }
+            else if ( materialChoice < 0.95f )
+            {
+                const gm::FloatRange albedoRange( 0.5f, 1.0f );
+                gm::Vec3f            albedo( rng.NextFloat( albedoRange ),
+                                             rng.NextFloat( albedoRange ),
+                                             rng.NextFloat( albedoRange ) );
+                float                fuzziness = rng.NextFloat( gm::FloatRange( 0.0f, 0.5f ) );
+                i_addSphere( center, 0.2f, std::make_shared< raytrace::Metal >( albedo, fuzziness ) );
+            }
+            else
+            {
+                i_addSphere( center, 0.2f, std::make_shared< raytrace::Dielectric >( 1.5 ) );
+            }
+        }
+    }
+
+    i_addSphere( gm::Vec3f( 0, 1, 0 ), 1.0, std::make_shared< raytrace::Dielectric >( 1.5 ) );
+    i_addSphere( gm::Vec3f( -4, 1, 0 ), 1.0, std::make_shared< raytrace::Lambert >( gm::Vec3f( 0.4, 0.2, 0.1 ) ) );
+    i_addSphere( gm::Vec3f( 4, 1, 0 ), 1.0, std::make_shared< raytrace::Metal >( gm::Vec3f( 0.7, 0.6, 0.5 ), 0.0 ) );
+}
+
+/// Create the scene of 10_whereNext.
+///
+/// \param i_aspectRatio The aspect ratio of the image.
+/// \param i_accelerator "bvh", "qbvh", "obvh" or "sphereSet", matching the options of 10_whereNext.
+/// \param i_bvhBuildMethod The build algorithm of the bvh, qbvh, and obvh accelerators.
+inline BenchmarkScene
+CreateWhereNextScene( float                    i_aspectRatio,
+                      const std::string&       i_accelerator,
+                      raytrace::BVHBuildMethod i_bvhBuildMethod = raytrace::BVHBuildMethod::BinnedSAH )
+{
+    const bool isLBVH = i_bvhBuildMethod == raytrace::BVHBuildMethod::LBVH;
+    BenchmarkScene scene( "10_whereNext/" + i_accelerator + ( isLBVH ? "/lbvh" : "" ),
+                          raytrace::Camera( gm::Vec3f( 13, 2, 3 ),
+                                            gm::Vec3f( 0, 0, 0 ),
+                                            gm::Vec3f( 0, 1, 0 ),
+                                            /* verticalFov */ 20.0f,
+                                            i_aspectRatio,
+                                            /* aperture */ 0.2f,
+                                            /* focalDistance */ 10.0f ) );
+
+    if ( i_accelerator == "sphereSet" )
+    {
+        std::unique_ptr< raytrace::SphereSet > sphereSet = std::make_unique< raytrace::SphereSet >();
+        PopulateWhereNextScene(
+            [ & ]( const gm::Vec3f& i_center, float i_radius, const raytrace::MaterialSharedPtr& i_material ) {
+                sphereSet->Append( i_center, i_radius, i_material );
+            } );
+        scene.m_sceneObject = std::move( sphereSet );
+    }
+    else
+    {
+        raytrace::SceneObjectPtrs sceneObjects;
+        PopulateWhereNextScene(
+            [ & ]( const gm::Vec3f& i_center, float i_radius, const raytrace::MaterialSharedPtr& i_material ) {
+                sceneObjects.push_back( std::make_unique< raytrace::Sphere >( i_center, i_radius, i_material ) );
+            } );
+        raytrace::BVHBuildSettings bvhSettings;
+        bvhSettings.m_method = i_bvhBuildMethod;
+        if ( i_accelerator == "qbvh" )
+        {
+            scene.m_sceneObject = std::make_unique< raytrace::QBVH >( std::move( sceneObjects ), bvhSettings );
+        }
+        else if ( i_accelerator == "obvh" )
+        {
+            scene.m_sceneObject = std::make_unique< raytrace::OBVH >( std::move( sceneObjects ), bvhSettings );
+        }
+        else
+        {
+            scene.m_sceneObject = std::make_unique< raytrace::BVH >( std::move( sceneObjects ), bvhSettings );
+        }
+    }
+
+    return scene;
+}
+
+/// Generate a field of \p i_sphereCount small spheres, scattered uniformly within a cube at unit density, for
+/// measuring acceleration structure builds at scale.
+inline raytrace::SceneObjectPtrs CreateSphereField( size_t i_sphereCount )
+{
+    raytrace::RandomNumberGenerator rng( 0, 0, c_benchmarkSeed );
+    raytrace::MaterialSharedPtr     material = std::make_shared< raytrace::Lambert >( gm::Vec3f( 0.5f, 0.5f, 0.5f ) );
+    const float                     extent   = std::cbrt( static_cast< float >( i_sphereCount ) );
+
+    raytrace::SceneObjectPtrs sceneObjects;
+    sceneObjects.reserve( i_sphereCount );
+    for ( size_t sphereIndex = 0; sphereIndex < i_sphereCount; ++sphereIndex )
+    {
+        gm::Vec3f center( rng.NextFloat() * extent, rng.NextFloat() * extent, rng.NextFloat() * extent );
+        float     radius = 0.1f + 0.2f * rng.NextFloat();
+        sceneObjects.push_back( std::make_unique< raytrace::Sphere >( center, radius, material ) );
+    }
+
+    return sceneObjects;
+}
@@ -0,0 +1,429 @@
+/// \file benchmarks/main.cpp
+///
+/// Ray throughput benchmarks over the chapter scenes, and BVH build benchmarks over a large sphere field.
+///
+/// Each ray benchmark measures a fixed, fully deterministic batch of rays.  Alongside catch2's own report, one line
+/// of JSON is printed per benchmark, carrying the ray count and throughput for regression tracking:
+///
+///     {"benchmark": "7_dielectrics/intersection", "rays": 24576, "meanNanoseconds": ..., "mraysPerSecond": ...,
+///      "nanosecondsPerRay": ...}
+///
+/// Each BVH build benchmark prints the quality of the built hierarchy, by the surface area heuristic:
+///
+///     {"benchmark": "bvhBuild/sah", "objects": 200000, "sahCost": ..., "nodes": ..., "leaves": ...}
+///
+/// The sampling benchmarks map uniform samples onto the unit sphere & disk, against a baseline calling into libm
+/// trig.  They are reported like the ray benchmarks, in units of samples:
+///
+///     {"benchmark": "sampling/unitDiskBatch", "samples": 65536, "meanNanoseconds": ..., "msamplesPerSecond": ...,
+///      "nanosecondsPerSample": ...}
+///
+/// Run with "--benchmark-samples <N>" to trade time for precision.
+
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#define CATCH_CONFIG_NO_POSIX_SIGNALS // The alternate signal stack size is not a constant expression in newer glibc.
+#include <catch2/catch.hpp>
+
+#include "benchmarkScenes.h"
+
+#include <raytrace/sampleMapping.h>
+
+#include <gm/base/constants.h>
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+/// \var c_imageSize
+///
+/// Image dimensions for the primary ray, intersection, and scatter benchmarks.
+static const gm::Vec2i c_imageSize( 192, 128 );
+
+/// \var c_renderSize
+///
+/// Image dimensions for the end-to-end benchmarks.
+static const gm::Vec2i c_renderSize( 96, 64 );
+
+/// \var c_renderSamplesPerPixel
+///
+/// Samples per-pixel for the end-to-end benchmarks.
+constexpr int c_renderSamplesPerPixel = 4;
+
+/// \class BenchmarkWork
+///
+/// The work processed per-iteration of a throughput benchmark.
+class BenchmarkWork final
+{
+public:
+    /// The number of units of work.
+    size_t m_count = 0;
+
+    /// The name of the unit of work, singular and in lower case, such as "ray" or "sample".
+    const char* m_unit = "ray";
+};
+
+/// Get the work processed per-iteration of each throughput benchmark, keyed by benchmark name.
+static std::map< std::string, BenchmarkWork >& BenchmarkWorks()
+{
+    static std::map< std::string, BenchmarkWork > s_works;
+    return s_works;
+}
+
+/// Record the number of rays processed per-iteration of the benchmark named \p i_name.
+///
+/// \return The benchmark name.
+static std::string RayBenchmarkName( const std::string& i_name, size_t i_rayCount )
+{
+    BenchmarkWorks()[ i_name ] = BenchmarkWork{i_rayCount, "ray"};
+    return i_name;
+}
+
+/// Record the number of samples mapped per-iteration of the benchmark named \p i_name.
+///
+/// \return The benchmark name.
+static std::string SampleBenchmarkName( const std::string& i_name, size_t i_sampleCount )
+{
+    BenchmarkWorks()[ i_name ] = BenchmarkWork{i_sampleCount, "sample"};
+    return i_name;
+}
+
+/// Get the lines of JSON to print once all the benchmarks have run.
+static std::vector< std::string >& ReportLines()
+{
+    static std::vector< std::string > s_lines;
+    return s_lines;
+}
+
+/// \class ThroughputListener
+///
+/// Collects the ray or sample throughput of each finished benchmark, and prints them as lines of JSON once all the
+/// benchmarks have run, so they are not interleaved with the console report.
+class ThroughputListener : public Catch::TestEventListenerBase
+{
+public:
+    using Catch::TestEventListenerBase::TestEventListenerBase;
+
+    virtual void benchmarkEnded( const Catch::BenchmarkStats<>& i_stats ) override
+    {
+        auto it = BenchmarkWorks().find( i_stats.info.name );
+        if ( it == BenchmarkWorks().end() || it->second.m_count == 0 )
+        {
+            return;
+        }
+
+        const BenchmarkWork& work               = it->second;
+        const double         meanNanoseconds    = i_stats.mean.point.count();
+        const double         nanosecondsPerUnit = meanNanoseconds / work.m_count;
+
+        std::string capitalizedUnit = work.m_unit;
+        capitalizedUnit[ 0 ]        = char( toupper( capitalizedUnit[ 0 ] ) );
+
+        char line[ 512 ];
+        snprintf( line,
+                  sizeof( line ),
+                  "{\"benchmark\": \"%s\", \"%ss\": %zu, \"meanNanoseconds\": %.1f, \"m%ssPerSecond\": %.4f, "
+                  "\"nanosecondsPer%s\": %.3f}",
+                  i_stats.info.name.c_str(),
+                  work.m_unit,
+                  work.m_count,
+                  meanNanoseconds,
+                  work.m_unit,
+                  1e3 / nanosecondsPerUnit,
+                  capitalizedUnit.c_str(),
+                  nanosecondsPerUnit );
+        ReportLines().push_back( line );
+    }
+
+    virtual void testRunEnded( const Catch::TestRunStats& ) override
+    {
+        for ( const std::string& line : ReportLines() )
+        {
+            printf( "%s\n", line.c_str() );
+        }
+        fflush( stdout );
+    }
+};
+
+CATCH_REGISTER_LISTENER( ThroughputListener )
+
+/// Generate one camera ray per pixel of an image of \p c_imageSize, with \p i_rayGenerator.
+///
+/// The pixel & lens samples are drawn up front, then the rays are generated as a single batch.
+template < typename LensT >
+static std::vector< raytrace::Ray >
+GeneratePrimaryRays( const raytrace::CameraRayGenerator< LensT >& i_rayGenerator )
+{
+    const int                pixelCount = c_imageSize.X() * c_imageSize.Y();
+    std::vector< gm::Vec2i > pixelCoords( pixelCount );
+    std::vector< gm::Vec2f > sampleOffsets( pixelCount );
+    std::vector< gm::Vec2f > lensSamples( pixelCount );
+    for ( int pixelIndex = 0; pixelIndex < pixelCount; ++pixelIndex )
+    {
+        raytrace::RandomNumberGenerator rng( pixelIndex, 0, c_benchmarkSeed );
+        pixelCoords[ pixelIndex ] = gm::Vec2i( pixelIndex % c_imageSize.X(), pixelIndex / c_imageSize.X() );
+        raytrace::CameraRayGenerator< LensT >::DrawSamples(
+            rng, sampleOffsets[ pixelIndex ], lensSamples[ pixelIndex ] );
+    }
+
+    raytrace::CameraRayGenerator< LensT >::MapLensSamples( lensSamples.data(), lensSamples.size() );
+
+    std::vector< raytrace::Ray > rays( pixelCount );
+    i_rayGenerator.GenerateRays(
+        pixelCoords.data(), sampleOffsets.data(), lensSamples.data(), rays.size(), rays.data() );
+    return rays;
+}
+
+/// Generate one camera ray per pixel of an image of \p c_imageSize, with the lens model of \p i_camera.
+static std::vector< raytrace::Ray > GeneratePrimaryRays( const raytrace::Camera& i_camera )
+{
+    return raytrace::DispatchLensModel(
+        i_camera, c_imageSize, []( const auto& i_rayGenerator ) { return GeneratePrimaryRays( i_rayGenerator ); } );
+}
+
+/// Render an image of \p c_renderSize on the calling thread.
+///
+/// \param i_scene The scene to render.
+/// \param io_rayCount Incremented by the number of rays tested for scene intersection.
+///
+/// \return Sum of all the sample colors, so the work cannot be optimized away.
+static gm::Vec3f RenderImage( const BenchmarkScene& i_scene, size_t& io_rayCount )
+{
+    // Default settings match the chapter programs.
+    const raytrace::PathTracerSettings pathTracer;
+    raytrace::PathStatistics           pathStatistics;
+
+    gm::Vec3f colorSum;
+    raytrace::DispatchLensModel( i_scene.m_camera, c_renderSize, [ & ]( const auto& i_rayGenerator ) {
+        for ( int yCoord = 0; yCoord < c_renderSize.Y(); ++yCoord )
+        {
+            for ( int xCoord = 0; xCoord < c_renderSize.X(); ++xCoord )
+            {
+                for ( int sampleIndex = 0; sampleIndex < c_renderSamplesPerPixel; ++sampleIndex )
+                {
+                    raytrace::RandomNumberGenerator rng(
+                        yCoord * c_renderSize.X() + xCoord, sampleIndex, c_benchmarkSeed );
+                    raytrace::Ray ray = i_rayGenerator.GenerateRay( gm::Vec2i( xCoord, yCoord ), rng );
+                    colorSum += raytrace::TracePath( ray, *i_scene.m_sceneObject, pathTracer, rng, &pathStatistics );
+                }
+            }
+        }
+    } );
+
+    io_rayCount += pathStatistics.m_rayCount;
+
+    return colorSum;
+}
+
+/// Run the primary ray, intersection, scatter, and end-to-end benchmarks over \p i_scene.
+static void RunSceneBenchmarks( const BenchmarkScene& i_scene )
+{
+    const raytrace::SceneObject& sceneObject = *i_scene.m_sceneObject;
+
+    // Primary ray generation.
+    BENCHMARK( RayBenchmarkName( i_scene.m_name + "/primaryRays", c_imageSize.X() * c_imageSize.Y() ) )
+    {
+        return GeneratePrimaryRays( i_scene.m_camera );
+    };
+
+    // Nearest-hit scene intersection of primary rays.
+    const std::vector< raytrace::Ray > primaryRays = GeneratePrimaryRays( i_scene.m_camera );
+    BENCHMARK( RayBenchmarkName( i_scene.m_name + "/intersection", primaryRays.size() ) )
+    {
+        int hitCount = 0;
+        for ( const raytrace::Ray& ray : primaryRays )
+        {
+            raytrace::HitRecord record;
+            hitCount += sceneObject.Hit( ray, c_magnitudeRange, record ) ? 1 : 0;
+        }
+        return hitCount;
+    };
+
+    // Material scattering at the primary hits.
+    std::vector< raytrace::Ray >       hitRays;
+    std::vector< raytrace::HitRecord > hitRecords;
+    for ( const raytrace::Ray& ray : primaryRays )
+    {
+        raytrace::HitRecord record;
+        if ( sceneObject.Hit( ray, c_magnitudeRange, record ) )
+        {
+            hitRays.push_back( ray );
+            hitRecords.push_back( record );
+        }
+    }
+
+    const raytrace::MaterialTable* materials = sceneObject.Materials();
+    BENCHMARK( RayBenchmarkName( i_scene.m_name + "/scatter", hitRecords.size() ) )
+    {
+        gm::Vec3f attenuationSum;
+        for ( size_t hitIndex = 0; hitIndex < hitRecords.size(); ++hitIndex )
+        {
+            raytrace::RandomNumberGenerator rng( hitIndex, 0, c_benchmarkSeed );
+            raytrace::Ray                   scatteredRay;
+            gm::Vec3f                       attenuation;
+            rng.SetBounce( 1 );
+            if ( raytrace::ScatterHit(
+                     materials, hitRays[ hitIndex ], hitRecords[ hitIndex ], rng, attenuation, scatteredRay ) )
+            {
+                attenuationSum += attenuation;
+            }
+        }
+        return attenuationSum;
+    };
+
+    // Path tracing, from camera ray generation through to the final bounce.
+    // Sampling is deterministic, thus every iteration traces the same number of rays.
+    size_t renderRayCount = 0;
+    RenderImage( i_scene, renderRayCount );
+
+    BENCHMARK( RayBenchmarkName( i_scene.m_name + "/endToEnd", renderRayCount ) )
+    {
+        size_t rayCount = 0;
+        return RenderImage( i_scene, rayCount );
+    };
+}
+
+static float ImageAspectRatio()
+{
+    return ( float ) c_imageSize.X() / c_imageSize.Y();
+}
+
+TEST_CASE( "7_dielectrics" )
+{
+    RunSceneBenchmarks( CreateDielectricsScene( ImageAspectRatio() ) );
+}
+
+TEST_CASE( "8_positionableCamera" )
+{
+    RunSceneBenchmarks( CreatePositionableCameraScene( ImageAspectRatio() ) );
+}
+
+TEST_CASE( "9_defocusBlur" )
+{
+    RunSceneBenchmarks( CreateDefocusBlurScene( ImageAspectRatio() ) );
+}
+
+TEST_CASE( "10_whereNext" )
+{
+    RunSceneBenchmarks( CreateWhereNextScene( ImageAspectRatio(), "bvh" ) );
+    RunSceneBenchmarks( CreateWhereNextScene( ImageAspectRatio(), "qbvh" ) );
+    RunSceneBenchmarks( CreateWhereNextScene( ImageAspectRatio(), "obvh" ) );
+    RunSceneBenchmarks( CreateWhereNextScene( ImageAspectRatio(), "bvh", raytrace::BVHBuildMethod::LBVH ) );
+    RunSceneBenchmarks( CreateWhereNextScene( ImageAspectRatio(), "sphereSet" ) );
+}
+
+/// \var c_mappedSampleCount
+///
+/// The number of uniform samples mapped per-iteration of the sampling benchmarks.
+constexpr size_t c_mappedSampleCount = 1 << 16;
+
+TEST_CASE( "sampling" )
+{
+    std::vector< gm::Vec2f > samples( c_mappedSampleCount );
+    for ( size_t sampleIndex = 0; sampleIndex < c_mappedSampleCount; ++sampleIndex )
+    {
+        raytrace::RandomNumberGenerator rng( sampleIndex, 0, c_benchmarkSeed );
+        samples[ sampleIndex ].X() = rng.NextFloat();
+        samples[ sampleIndex ].Y() = rng.NextFloat();
+    }
+
+    std::vector< gm::Vec3f > directions( c_mappedSampleCount );
+    std::vector< gm::Vec2f > points( c_mappedSampleCount );
+
+    // Baseline of the previous mapping, calling into libm for the sine & cosine of the azimuth.
+    BENCHMARK( SampleBenchmarkName( "sampling/unitVectorLibm", c_mappedSampleCount ) )
+    {
+        for ( size_t sampleIndex = 0; sampleIndex < samples.size(); ++sampleIndex )
+        {
+            const float angle         = samples[ sampleIndex ].X() * 2.0f * gm::Pi;
+            const float z             = samples[ sampleIndex ].Y() * 2.0f - 1.0f;
+            const float r             = std::sqrt( 1.0f - z * z );
+            directions[ sampleIndex ] = gm::Vec3f( r * std::cos( angle ), r * std::sin( angle ), z );
+        }
+        return directions.back();
+    };
+
+    BENCHMARK( SampleBenchmarkName( "sampling/unitVectorScalar", c_mappedSampleCount ) )
+    {
+        raytrace::UniformSphereSamplesScalar( samples.data(), samples.size(), directions.data() );
+        return directions.back();
+    };
+
+    BENCHMARK( SampleBenchmarkName( "sampling/unitVectorBatch", c_mappedSampleCount ) )
+    {
+        raytrace::UniformSphereSamples( samples.data(), samples.size(), directions.data() );
+        return directions.back();
+    };
+
+    // Baseline of a uniform polar mapping, calling into libm for the sine & cosine of the angle.
+    BENCHMARK( SampleBenchmarkName( "sampling/unitDiskLibm", c_mappedSampleCount ) )
+    {
+        for ( size_t sampleIndex = 0; sampleIndex < samples.size(); ++sampleIndex )
+        {
+            const float angle     = samples[ sampleIndex ].X() * 2.0f * gm::Pi;
+            const float radius    = std::sqrt( samples[ sampleIndex ].Y() );
+            points[ sampleIndex ] = gm::Vec2f( radius * std::cos( angle ), radius * std::sin( angle ) );
+        }
+        return points.back();
+    };
+
+    BENCHMARK( SampleBenchmarkName( "sampling/unitDiskScalar", c_mappedSampleCount ) )
+    {
+        raytrace::ConcentricDiskSamplesScalar( samples.data(), samples.size(), points.data() );
+        return points.back();
+    };
+
+    BENCHMARK( SampleBenchmarkName( "sampling/unitDiskBatch", c_mappedSampleCount ) )
+    {
+        raytrace::ConcentricDiskSamples( samples.data(), samples.size(), points.data() );
+        return points.back();
+    };
+}
+
+/// \var c_buildSphereCount
+///
+/// The number of spheres in the BVH build benchmarks.
+constexpr size_t c_buildSphereCount = 200000;
+
+/// Benchmark building a BVH over a large sphere field with \p i_method, reporting the quality of the hierarchy.
+static void RunBVHBuildBenchmark( const std::string& i_name, raytrace::BVHBuildMethod i_method )
+{
+    raytrace::BVHBuildSettings settings;
+    settings.m_method = i_method;
+
+    raytrace::BVH bvh( CreateSphereField( c_buildSphereCount ), settings );
+
+    char line[ 512 ];
+    snprintf( line,
+              sizeof( line ),
+              "{\"benchmark\": \"%s\", \"objects\": %zu, \"sahCost\": %.3f, \"nodes\": %zu, \"leaves\": %zu}",
+              i_name.c_str(),
+              c_buildSphereCount,
+              bvh.BuildStatistics().m_sahCost,
+              bvh.BuildStatistics().m_nodeCount,
+              bvh.BuildStatistics().m_leafCount );
+    ReportLines().push_back( line );
+
+    BENCHMARK_ADVANCED( std::string( i_name ) )( Catch::Benchmark::Chronometer i_meter )
+    {
+        // The build consumes its input, and the hierarchies are destroyed outside of the measurement.
+        std::vector< raytrace::SceneObjectPtrs >         inputs( i_meter.runs() );
+        std::vector< std::unique_ptr< raytrace::BVH > > outputs( i_meter.runs() );
+        for ( raytrace::SceneObjectPtrs& input : inputs )
+        {
+            input = CreateSphereField( c_buildSphereCount );
+        }
+
+        i_meter.measure( [ & ]( int i_run ) {
+            outputs[ i_run ] = std::make_unique< raytrace::BVH >( std::move( inputs[ i_run ] ), settings );
+        } );
+    };
+}
+
+TEST_CASE( "bvhBuild" )
+{
+    RunBVHBuildBenchmark( "bvhBuild/sah", raytrace::BVHBuildMethod::BinnedSAH );
+    RunBVHBuildBenchmark( "bvhBuild/lbvh", raytrace::BVHBuildMethod::LBVH );
+}
@@ -0,0 +1,672 @@
+/// \file benchmarks/tests.cpp
+///
+/// Correctness tests of the components measured by the benchmarks: the accelerators against brute force, the
+/// random number streams, the stratification of the samplers, checkpoint files, the SIMD kernels against their
+/// scalar references, and the render modes which promise images identical to each other.
+///
+/// Unlike the benchmarks, these run quickly, and are registered with ctest.
+
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_NO_POSIX_SIGNALS // The alternate signal stack size is not a constant expression in newer glibc.
+#include <catch2/catch.hpp>
+
+#include "benchmarkScenes.h"
+
+#include <raytrace/checkpoint.h>
+#include <raytrace/randomUnitVector.h>
+#include <raytrace/renderSettings.h>
+#include <raytrace/renderer.h>
+#include <raytrace/sampleMapping.h>
+#include <raytrace/sampler.h>
+
+#include <gm/base/constants.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <utility>
+#include <vector>
+
+/// \class TestSphere
+///
+/// The origin & radius of a sphere, from which equivalent scene objects are created for each accelerator.
+class TestSphere final
+{
+public:
+    gm::Vec3f m_origin;
+    float     m_radius = 0.0f;
+};
+
+/// \var c_testSphereCount
+///
+/// The number of spheres in the accelerator tests.  Enough for deep hierarchies with many leaves.
+constexpr size_t c_testSphereCount = 1000;
+
+/// \var c_testRayCount
+///
+/// The number of rays cast through the spheres in the accelerator tests.
+constexpr size_t c_testRayCount = 4000;
+
+/// Create a field of overlapping spheres, with a fixed seed.
+static std::vector< TestSphere > CreateTestSpheres()
+{
+    raytrace::RandomNumberGenerator rng( 0, 0, c_benchmarkSeed );
+    const float                     extent = std::cbrt( static_cast< float >( c_testSphereCount ) );
+
+    std::vector< TestSphere > spheres( c_testSphereCount );
+    for ( TestSphere& sphere : spheres )
+    {
+        sphere.m_origin = gm::Vec3f( rng.NextFloat() * extent, rng.NextFloat() * extent, rng.NextFloat() * extent );
+        sphere.m_radius = 0.1f + 0.5f * rng.NextFloat();
+    }
+
+    return spheres;
+}
+
+/// Create one \ref raytrace::Sphere per sphere of \p i_spheres.
+static raytrace::SceneObjectPtrs CreateSphereObjects( const std::vector< TestSphere >&   i_spheres,
+                                                      const raytrace::MaterialSharedPtr& i_material )
+{
+    raytrace::SceneObjectPtrs sceneObjects;
+    for ( const TestSphere& sphere : i_spheres )
+    {
+        sceneObjects.push_back( std::make_unique< raytrace::Sphere >( sphere.m_origin, sphere.m_radius, i_material ) );
+    }
+
+    return sceneObjects;
+}
+
+/// Create rays from origins within and around the sphere field, in uniformly distributed directions.
+static std::vector< raytrace::Ray > CreateTestRays()
+{
+    const float extent = std::cbrt( static_cast< float >( c_testSphereCount ) );
+
+    std::vector< raytrace::Ray > rays;
+    for ( size_t rayIndex = 0; rayIndex < c_testRayCount; ++rayIndex )
+    {
+        // Origins are drawn within the bounds of the field, expanded by half on each side.
+        raytrace::RandomNumberGenerator rng( rayIndex, 0, c_benchmarkSeed + 1 );
+        gm::Vec3f                       origin;
+        origin.X() = ( rng.NextFloat() * 2.0f - 0.5f ) * extent;
+        origin.Y() = ( rng.NextFloat() * 2.0f - 0.5f ) * extent;
+        origin.Z() = ( rng.NextFloat() * 2.0f - 0.5f ) * extent;
+        rays.push_back( raytrace::Ray( origin, raytrace::RandomUnitVector( rng ) ) );
+    }
+
+    return rays;
+}
+
+/// Find the nearest hit of \p i_ray against every object of \p i_sceneObjects in turn.
+static bool BruteForceHit( const raytrace::SceneObjectPtrs& i_sceneObjects,
+                           const raytrace::Ray&             i_ray,
+                           raytrace::HitRecord&             o_record )
+{
+    bool           objectHit = false;
+    gm::FloatRange magnitudeRange( c_magnitudeRange );
+    for ( const raytrace::SceneObjectPtr& sceneObject : i_sceneObjects )
+    {
+        if ( sceneObject->Hit( i_ray, magnitudeRange, o_record ) )
+        {
+            objectHit      = true;
+            magnitudeRange = gm::FloatRange( c_magnitudeRange.Min(), o_record.m_magnitude );
+        }
+    }
+
+    return objectHit;
+}
+
+/// Check that every hit of \p i_accelerator matches the brute force hit over \p i_sceneObjects.
+static void CheckHitsMatchBruteForce( const raytrace::SceneObject&     i_accelerator,
+                                      const raytrace::SceneObjectPtrs& i_sceneObjects )
+{
+    size_t hitCount = 0;
+    for ( const raytrace::Ray& ray : CreateTestRays() )
+    {
+        raytrace::HitRecord expected;
+        raytrace::HitRecord actual;
+        const bool          expectedHit = BruteForceHit( i_sceneObjects, ray, expected );
+        const bool          actualHit   = i_accelerator.Hit( ray, c_magnitudeRange, actual );
+        REQUIRE( actualHit == expectedHit );
+        if ( !expectedHit )
+        {
+            continue;
+        }
+
+        ++hitCount;
+        CHECK( actual.m_magnitude == Approx( expected.m_magnitude ).epsilon( 1e-4 ) );
+        CHECK( actual.m_normal.X() == Approx( expected.m_normal.X() ).margin( 1e-3 ) );
+        CHECK( actual.m_normal.Y() == Approx( expected.m_normal.Y() ).margin( 1e-3 ) );
+        CHECK( actual.m_normal.Z() == Approx( expected.m_normal.Z() ).margin( 1e-3 ) );
+    }
+
+    // Both hits & misses are exercised.
+    CHECK( hitCount > c_testRayCount / 8 );
+    CHECK( hitCount < c_testRayCount );
+}
+
+TEST_CASE( "acceleratorHits" )
+{
+    const std::vector< TestSphere >   spheres  = CreateTestSpheres();
+    const raytrace::MaterialSharedPtr material = std::make_shared< raytrace::Lambert >( gm::Vec3f( 0.5f, 0.5f, 0.5f ) );
+    const raytrace::SceneObjectPtrs   sceneObjects = CreateSphereObjects( spheres, material );
+
+    raytrace::BVHBuildSettings lbvhSettings;
+    lbvhSettings.m_method = raytrace::BVHBuildMethod::LBVH;
+
+    SECTION( "bvh" )
+    {
+        raytrace::BVH bvh( CreateSphereObjects( spheres, material ) );
+        CheckHitsMatchBruteForce( bvh, sceneObjects );
+    }
+
+    SECTION( "lbvh" )
+    {
+        raytrace::BVH bvh( CreateSphereObjects( spheres, material ), lbvhSettings );
+        CheckHitsMatchBruteForce( bvh, sceneObjects );
+    }
+
+    SECTION( "qbvh" )
+    {
+        raytrace::QBVH qbvh( CreateSphereObjects( spheres, material ) );
+        CheckHitsMatchBruteForce( qbvh, sceneObjects );
+    }
+
+    SECTION( "obvh" )
+    {
+        raytrace::OBVH obvh( CreateSphereObjects( spheres, material ) );
+        CheckHitsMatchBruteForce( obvh, sceneObjects );
+    }
+
+    SECTION( "obvh/lbvh" )
+    {
+        raytrace::OBVH obvh( CreateSphereObjects( spheres, material ), lbvhSettings );
+        CheckHitsMatchBruteForce( obvh, sceneObjects );
+    }
+
+    SECTION( "sphereSet" )
+    {
+        raytrace::SphereSet sphereSet;
+        for ( const TestSphere& sphere : spheres )
+        {
+            sphereSet.Append( sphere.m_origin, sphere.m_radius, material );
+        }
+        CheckHitsMatchBruteForce( sphereSet, sceneObjects );
+    }
+}
+
+/// Compute the Pearson correlation coefficient of \p i_values.
+static double Correlation( const std::vector< std::pair< float, float > >& i_values )
+{
+    double xSum        = 0.0;
+    double ySum        = 0.0;
+    double xSquaredSum = 0.0;
+    double ySquaredSum = 0.0;
+    double productSum  = 0.0;
+    for ( const std::pair< float, float >& value : i_values )
+    {
+        xSum += value.first;
+        ySum += value.second;
+        xSquaredSum += value.first * value.first;
+        ySquaredSum += value.second * value.second;
+        productSum += value.first * value.second;
+    }
+
+    const double count      = static_cast< double >( i_values.size() );
+    const double covariance = productSum / count - ( xSum / count ) * ( ySum / count );
+    const double xVariance  = xSquaredSum / count - ( xSum / count ) * ( xSum / count );
+    const double yVariance  = ySquaredSum / count - ( ySum / count ) * ( ySum / count );
+    return covariance / std::sqrt( xVariance * yVariance );
+}
+
+/// \var c_streamCount
+///
+/// The number of random number streams compared by the random number generator tests.
+constexpr uint32_t c_streamCount = 16384;
+
+/// \var c_maxCorrelation
+///
+/// Bound of the correlation of independent streams, at several standard deviations for \ref c_streamCount pairs.
+constexpr double c_maxCorrelation = 0.04;
+
+TEST_CASE( "randomNumberStreams" )
+{
+    SECTION( "reproducible" )
+    {
+        raytrace::RandomNumberGenerator first( 7, 3, 11 );
+        raytrace::RandomNumberGenerator second( 7, 3, 11 );
+        for ( int drawIndex = 0; drawIndex < 64; ++drawIndex )
+        {
+            REQUIRE( first.NextUInt() == second.NextUInt() );
+        }
+    }
+
+    SECTION( "independent of neighboring pixels, samples & seeds" )
+    {
+        std::vector< std::pair< float, float > > pixelPairs;
+        std::vector< std::pair< float, float > > samplePairs;
+        std::vector< std::pair< float, float > > seedPairs;
+        std::vector< std::pair< float, float > > drawPairs;
+        for ( uint32_t streamIndex = 0; streamIndex < c_streamCount; ++streamIndex )
+        {
+            raytrace::RandomNumberGenerator rng( streamIndex, 0 );
+            raytrace::RandomNumberGenerator nextPixel( streamIndex + 1, 0 );
+            raytrace::RandomNumberGenerator nextSample( streamIndex, 1 );
+            raytrace::RandomNumberGenerator nextSeed( streamIndex, 0, 1 );
+
+            const float value = rng.NextFloat();
+            pixelPairs.emplace_back( value, nextPixel.NextFloat() );
+            samplePairs.emplace_back( value, nextSample.NextFloat() );
+            seedPairs.emplace_back( value, nextSeed.NextFloat() );
+            drawPairs.emplace_back( value, rng.NextFloat() );
+        }
+
+        CHECK( std::abs( Correlation( pixelPairs ) ) < c_maxCorrelation );
+        CHECK( std::abs( Correlation( samplePairs ) ) < c_maxCorrelation );
+        CHECK( std::abs( Correlation( seedPairs ) ) < c_maxCorrelation );
+        CHECK( std::abs( Correlation( drawPairs ) ) < c_maxCorrelation );
+    }
+
+    SECTION( "bounces are independent of the draws of previous bounces" )
+    {
+        raytrace::RandomNumberGenerator few( 5, 2 );
+        raytrace::RandomNumberGenerator many( 5, 2 );
+        few.SetBounce( 1 );
+        few.NextFloat();
+        many.SetBounce( 1 );
+        for ( int drawIndex = 0; drawIndex < 10; ++drawIndex )
+        {
+            many.NextFloat();
+        }
+
+        few.SetBounce( 2 );
+        many.SetBounce( 2 );
+        for ( int drawIndex = 0; drawIndex < 8; ++drawIndex )
+        {
+            REQUIRE( few.NextFloat() == many.NextFloat() );
+        }
+    }
+
+    SECTION( "leading dimensions are drawn from the sampler" )
+    {
+        const raytrace::Sampler         sampler( raytrace::SamplerType::Sobol, 16, 16, 0 );
+        raytrace::RandomNumberGenerator rng( 9, 4, 0, &sampler );
+        rng.SetBounce( 1 );
+        for ( uint32_t drawIndex = 0; drawIndex < raytrace::c_samplerDimensionsPerBounce; ++drawIndex )
+        {
+            REQUIRE( rng.NextFloat() ==
+                     sampler.Sample1D( 9, 4, raytrace::c_samplerDimensionsPerBounce + drawIndex ) );
+        }
+    }
+}
+
+/// Check that each cell of a grid of \p i_xCellCount by \p i_yCellCount cells, over the unit square, holds exactly
+/// one of \p i_samples.
+static void CheckStratified( const std::vector< gm::Vec2f >& i_samples, int i_xCellCount, int i_yCellCount )
+{
+    REQUIRE( static_cast< int >( i_samples.size() ) == i_xCellCount * i_yCellCount );
+
+    std::set< int > cells;
+    for ( const gm::Vec2f& sample : i_samples )
+    {
+        REQUIRE( sample.X() >= 0.0f );
+        REQUIRE( sample.X() < 1.0f );
+        REQUIRE( sample.Y() >= 0.0f );
+        REQUIRE( sample.Y() < 1.0f );
+        const int xCell = static_cast< int >( sample.X() * i_xCellCount );
+        const int yCell = static_cast< int >( sample.Y() * i_yCellCount );
+        cells.insert( yCell * i_xCellCount + xCell );
+    }
+
+    CHECK( cells.size() == i_samples.size() );
+}
+
+/// Get the samples \p i_sampleBegin to \p i_sampleBegin + \p i_sampleCount of a pixel & dimension pair.
+static std::vector< gm::Vec2f > PixelSamples( const raytrace::Sampler& i_sampler,
+                                              uint32_t                 i_pixelIndex,
+                                              uint32_t                 i_dimensionPair,
+                                              uint32_t                 i_sampleBegin,
+                                              uint32_t                 i_sampleCount )
+{
+    std::vector< gm::Vec2f > samples;
+    for ( uint32_t sampleIndex = i_sampleBegin; sampleIndex < i_sampleBegin + i_sampleCount; ++sampleIndex )
+    {
+        samples.push_back( i_sampler.Sample2D( i_pixelIndex, sampleIndex, i_dimensionPair ) );
+    }
+
+    return samples;
+}
+
+TEST_CASE( "samplerStratification" )
+{
+    constexpr int c_strataPerAxis = 4;
+    constexpr int c_sampleCount   = c_strataPerAxis * c_strataPerAxis;
+
+    SECTION( "stratified" )
+    {
+        // Each set of samples, one per stratum, covers every stratum.
+        const raytrace::Sampler sampler( raytrace::SamplerType::Stratified, 8, c_sampleCount, 3 );
+        for ( uint32_t pixelIndex = 0; pixelIndex < 8; ++pixelIndex )
+        {
+            for ( uint32_t dimensionPair = 0; dimensionPair < 4; ++dimensionPair )
+            {
+                for ( uint32_t sampleBegin = 0; sampleBegin < 3 * c_sampleCount; sampleBegin += c_sampleCount )
+                {
+                    CheckStratified( PixelSamples( sampler, pixelIndex, dimensionPair, sampleBegin, c_sampleCount ),
+                                     c_strataPerAxis,
+                                     c_strataPerAxis );
+                }
+            }
+        }
+    }
+
+    SECTION( "sobol" )
+    {
+        // Every power-of-two prefix is a (0,2)-net: each elementary interval of its size holds exactly one sample.
+        const raytrace::Sampler sampler( raytrace::SamplerType::Sobol, 8, c_sampleCount, 3 );
+        for ( uint32_t pixelIndex = 0; pixelIndex < 8; ++pixelIndex )
+        {
+            for ( uint32_t dimensionPair = 0; dimensionPair < 4; ++dimensionPair )
+            {
+                for ( int sampleCountLog2 = 1; sampleCountLog2 <= 6; ++sampleCountLog2 )
+                {
+                    const int                      sampleCount = 1 << sampleCountLog2;
+                    const std::vector< gm::Vec2f > samples =
+                        PixelSamples( sampler, pixelIndex, dimensionPair, 0, sampleCount );
+                    for ( int xCellCountLog2 = 0; xCellCountLog2 <= sampleCountLog2; ++xCellCountLog2 )
+                    {
+                        CheckStratified(
+                            samples, 1 << xCellCountLog2, 1 << ( sampleCountLog2 - xCellCountLog2 ) );
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE( "checkpointRoundTrip" )
+{
+    const char* const filePath = "checkpointRoundTrip.checkpoint";
+
+    raytrace::RenderSettings settings;
+    settings.m_seed                          = 5;
+    settings.m_sampling.m_maxSamplesPerPixel = 8;
+
+    raytrace::ImageBuffer< raytrace::SampleStatistics > accumulation( 7, 5 );
+    raytrace::RandomNumberGenerator                     rng( 0, 0, c_benchmarkSeed );
+    for ( int yCoord = 0; yCoord < accumulation.Height(); ++yCoord )
+    {
+        for ( int xCoord = 0; xCoord < accumulation.Width(); ++xCoord )
+        {
+            for ( int sampleIndex = 0; sampleIndex < ( xCoord + yCoord ) % 5; ++sampleIndex )
+            {
+                accumulation( xCoord, yCoord )
+                    .Add( gm::Vec3f( rng.NextFloat(), rng.NextFloat(), rng.NextFloat() * 4.0f ) );
+            }
+        }
+    }
+
+    REQUIRE( raytrace::WriteCheckpoint( filePath, settings, accumulation, 3 ) );
+
+    SECTION( "matching settings" )
+    {
+        raytrace::ImageBuffer< raytrace::SampleStatistics > resumed( 1, 1 );
+        int                                                 passCount = 0;
+        REQUIRE( raytrace::ReadCheckpoint( filePath, settings, resumed, passCount ) );
+        CHECK( passCount == 3 );
+        REQUIRE( resumed.Width() == accumulation.Width() );
+        REQUIRE( resumed.Height() == accumulation.Height() );
+        CHECK( std::memcmp( resumed.Data(),
+                            accumulation.Data(),
+                            sizeof( raytrace::SampleStatistics ) * accumulation.Width() * accumulation.Height() ) ==
+               0 );
+    }
+
+    SECTION( "mismatched settings" )
+    {
+        raytrace::RenderSettings otherSettings = settings;
+        otherSettings.m_seed                   = 6;
+
+        raytrace::ImageBuffer< raytrace::SampleStatistics > resumed( 1, 1 );
+        int                                                 passCount = 0;
+        CHECK_FALSE( raytrace::ReadCheckpoint( filePath, otherSettings, resumed, passCount ) );
+    }
+
+    std::remove( filePath );
+}
+
+/// \var c_renderTestSize
+///
+/// Image dimensions of the render tests.
+static const gm::Vec2i c_renderTestSize( 48, 32 );
+
+/// \class RenderedImage
+///
+/// The output of a render test: the image, and the number of samples taken per-pixel.
+class RenderedImage final
+{
+public:
+    inline RenderedImage()
+        : m_image( c_renderTestSize.X(), c_renderTestSize.Y() )
+        , m_sampleCounts( 0, 0 )
+    {
+    }
+
+    raytrace::RGBImageBuffer     m_image;
+    raytrace::ImageBuffer< int > m_sampleCounts;
+    raytrace::RenderStatistics   m_statistics;
+};
+
+/// Create the settings of the render tests: adaptive sampling, with Russian roulette, and a fixed seed.
+static raytrace::RenderSettings CreateRenderTestSettings()
+{
+    raytrace::RenderSettings settings;
+    settings.m_sampling.m_minSamplesPerPixel           = 4;
+    settings.m_sampling.m_maxSamplesPerPixel           = 32;
+    settings.m_sampling.m_errorThreshold               = 0.1f;
+    settings.m_pathTracer.m_russianRouletteStartBounce = 3;
+    settings.m_seed                                    = 3;
+    settings.m_threadCount                             = 4;
+    return settings;
+}
+
+/// Render the scene of 10_whereNext, which covers every material and the thin lens, with \p i_settings.
+///
+/// \param io_renderer The renderer, which may be resuming an interrupted render.
+/// \param i_scene The scene to render.
+/// \param i_passFunction Optional function to invoke after each complete pass.
+static RenderedImage RenderTestScene( raytrace::Renderer&                     io_renderer,
+                                      const BenchmarkScene&                   i_scene,
+                                      const raytrace::Renderer::PassFunction& i_passFunction =
+                                          raytrace::Renderer::PassFunction() )
+{
+    RenderedImage rendered;
+    io_renderer.Render( i_scene.m_camera,
+                        *i_scene.m_sceneObject,
+                        rendered.m_image,
+                        raytrace::Renderer::TileFunction(),
+                        i_passFunction );
+    rendered.m_sampleCounts = io_renderer.SampleCounts();
+    rendered.m_statistics   = io_renderer.Statistics();
+    return rendered;
+}
+
+/// Render the scene of 10_whereNext with \p i_settings, on a new renderer.
+static RenderedImage RenderTestScene( const raytrace::RenderSettings& i_settings, const BenchmarkScene& i_scene )
+{
+    raytrace::Renderer renderer( i_settings );
+    return RenderTestScene( renderer, i_scene );
+}
+
+/// Create the scene of the render tests.
+static BenchmarkScene CreateRenderTestScene()
+{
+    return CreateWhereNextScene( float( c_renderTestSize.X() ) / c_renderTestSize.Y(), "bvh" );
+}
+
+/// Check that the images & sample counts of \p i_actual and \p i_expected are bit-identical.
+static void CheckRendersIdentical( const RenderedImage& i_actual, const RenderedImage& i_expected )
+{
+    const size_t pixelCount = c_renderTestSize.X() * c_renderTestSize.Y();
+    REQUIRE( i_actual.m_sampleCounts.Width() == c_renderTestSize.X() );
+    REQUIRE( i_actual.m_sampleCounts.Height() == c_renderTestSize.Y() );
+    REQUIRE( i_expected.m_sampleCounts.Width() == c_renderTestSize.X() );
+    REQUIRE( i_expected.m_sampleCounts.Height() == c_renderTestSize.Y() );
+    CHECK( std::memcmp( i_actual.m_image.Data(), i_expected.m_image.Data(), sizeof( gm::Vec3f ) * pixelCount ) == 0 );
+    CHECK( std::memcmp(
+               i_actual.m_sampleCounts.Data(), i_expected.m_sampleCounts.Data(), sizeof( int ) * pixelCount ) == 0 );
+}
+
+/// Check that adaptive sampling took effect in \p i_rendered: some pixels converged early, and some did not.
+static void CheckSamplingAdaptive( const RenderedImage& i_rendered, const raytrace::RenderSettings& i_settings )
+{
+    const int* sampleCounts    = i_rendered.m_sampleCounts.Data();
+    const int* sampleCountsEnd = sampleCounts + c_renderTestSize.X() * c_renderTestSize.Y();
+    CHECK( *std::min_element( sampleCounts, sampleCountsEnd ) < i_settings.m_sampling.m_maxSamplesPerPixel );
+    CHECK( *std::max_element( sampleCounts, sampleCountsEnd ) == i_settings.m_sampling.m_maxSamplesPerPixel );
+}
+
+TEST_CASE( "wavefrontMatchesScalar" )
+{
+    const BenchmarkScene     scene    = CreateRenderTestScene();
+    raytrace::RenderSettings settings = CreateRenderTestSettings();
+
+    const RenderedImage scalar = RenderTestScene( settings, scene );
+    CheckSamplingAdaptive( scalar, settings );
+
+    settings.m_wavefront          = true;
+    const RenderedImage wavefront = RenderTestScene( settings, scene );
+    CheckRendersIdentical( wavefront, scalar );
+}
+
+TEST_CASE( "progressiveMatchesSinglePass" )
+{
+    const BenchmarkScene     scene    = CreateRenderTestScene();
+    raytrace::RenderSettings settings = CreateRenderTestSettings();
+    settings.m_wavefront              = GENERATE( false, true );
+
+    const RenderedImage singlePass = RenderTestScene( settings, scene );
+    CheckSamplingAdaptive( singlePass, settings );
+    CHECK( singlePass.m_statistics.m_passCount == 1 );
+
+    settings.m_progressive          = true;
+    const RenderedImage progressive = RenderTestScene( settings, scene );
+    CHECK( progressive.m_statistics.m_passCount > 1 );
+    CheckRendersIdentical( progressive, singlePass );
+}
+
+TEST_CASE( "resumedRenderMatchesUninterrupted" )
+{
+    const char* const        filePath = "resumedRender.checkpoint";
+    const BenchmarkScene     scene    = CreateRenderTestScene();
+    raytrace::RenderSettings settings = CreateRenderTestSettings();
+    settings.m_progressive            = true;
+    settings.m_wavefront              = GENERATE( false, true );
+
+    // The samples of the first passes are taken from an uninterrupted render, as the time limit would leave them.
+    constexpr int                                       c_interruptedPassCount = 3;
+    raytrace::ImageBuffer< raytrace::SampleStatistics > interruptedAccumulation( 0, 0 );
+    raytrace::Renderer                                  renderer( settings );
+    const RenderedImage uninterrupted = RenderTestScene( renderer, scene, [ & ]( const raytrace::RenderPass& i_pass ) {
+        if ( i_pass.m_passIndex + 1 == c_interruptedPassCount )
+        {
+            interruptedAccumulation = renderer.Accumulation();
+        }
+    } );
+    CheckSamplingAdaptive( uninterrupted, settings );
+    REQUIRE( uninterrupted.m_statistics.m_passCount > c_interruptedPassCount );
+
+    REQUIRE( raytrace::WriteCheckpoint( filePath, settings, interruptedAccumulation, c_interruptedPassCount ) );
+    raytrace::ImageBuffer< raytrace::SampleStatistics > checkpointAccumulation( 0, 0 );
+    int                                                 passCount = 0;
+    REQUIRE( raytrace::ReadCheckpoint( filePath, settings, checkpointAccumulation, passCount ) );
+    std::remove( filePath );
+    REQUIRE( passCount == c_interruptedPassCount );
+
+    raytrace::Renderer resumedRenderer( settings );
+    resumedRenderer.ResumeFrom( checkpointAccumulation, passCount );
+    const RenderedImage resumed = RenderTestScene( resumedRenderer, scene );
+    CHECK( resumed.m_statistics.m_passCount == uninterrupted.m_statistics.m_passCount );
+    CheckRendersIdentical( resumed, uninterrupted );
+}
+
+/// Create \p i_count uniform samples in [0,1)^2, including the corners & edges of the square.
+static std::vector< gm::Vec2f > CreateUniformSamples( size_t i_count )
+{
+    std::vector< gm::Vec2f > samples = {gm::Vec2f( 0.0f, 0.0f ),
+                                        gm::Vec2f( 0.5f, 0.5f ),
+                                        gm::Vec2f( 0.0f, 0.99999994f ),
+                                        gm::Vec2f( 0.99999994f, 0.0f ),
+                                        gm::Vec2f( 0.99999994f, 0.99999994f )};
+    for ( uint32_t sampleIndex = 0; samples.size() < i_count; ++sampleIndex )
+    {
+        raytrace::RandomNumberGenerator rng( sampleIndex, 0, c_benchmarkSeed );
+        const float                     xValue = rng.NextFloat();
+        samples.push_back( gm::Vec2f( xValue, rng.NextFloat() ) );
+    }
+
+    return samples;
+}
+
+/// \var c_mappedSampleCount
+///
+/// The number of samples mapped by the sampling tests.  Not a multiple of the SIMD width, to exercise the tails of
+/// the batch kernels.
+constexpr size_t c_mappedSampleCount = 4099;
+
+TEST_CASE( "sampleMapping" )
+{
+    const std::vector< gm::Vec2f > samples = CreateUniformSamples( c_mappedSampleCount );
+
+    SECTION( "sinCosTurns" )
+    {
+        for ( const gm::Vec2f& sample : samples )
+        {
+            float sine;
+            float cosine;
+            raytrace::SinCosTurns( sample.X(), sine, cosine );
+            CHECK( sine == Approx( std::sin( double( sample.X() ) * 2.0 * gm::Pi ) ).margin( 1e-6 ) );
+            CHECK( cosine == Approx( std::cos( double( sample.X() ) * 2.0 * gm::Pi ) ).margin( 1e-6 ) );
+        }
+    }
+
+    SECTION( "concentricDisk" )
+    {
+        std::vector< gm::Vec2f > points( samples.size() );
+        raytrace::ConcentricDiskSamplesScalar( samples.data(), samples.size(), points.data() );
+        for ( size_t sampleIndex = 0; sampleIndex < samples.size(); ++sampleIndex )
+        {
+            // Each concentric square maps onto the circle of the same radius.
+            const float radius = std::max( std::abs( samples[ sampleIndex ].X() * 2.0f - 1.0f ),
+                                           std::abs( samples[ sampleIndex ].Y() * 2.0f - 1.0f ) );
+            const gm::Vec2f& point = points[ sampleIndex ];
+            CHECK( std::sqrt( point.X() * point.X() + point.Y() * point.Y() ) == Approx( radius ).margin( 1e-6 ) );
+        }
+
+#if defined( RAYTRACE_X86 )
+        std::vector< gm::Vec2f > batchPoints( samples.size() );
+        raytrace::ConcentricDiskSamplesSSE2( samples.data(), samples.size(), batchPoints.data() );
+        CHECK( std::memcmp( batchPoints.data(), points.data(), sizeof( gm::Vec2f ) * points.size() ) == 0 );
+#endif
+    }
+
+    SECTION( "uniformSphere" )
+    {
+        std::vector< gm::Vec3f > directions( samples.size() );
+        raytrace::UniformSphereSamplesScalar( samples.data(), samples.size(), directions.data() );
+        for ( size_t sampleIndex = 0; sampleIndex < samples.size(); ++sampleIndex )
+        {
+            const gm::Vec3f& direction = directions[ sampleIndex ];
+            CHECK( direction.X() * direction.X() + direction.Y() * direction.Y() + direction.Z() * direction.Z() ==
+                   Approx( 1.0f ).margin( 1e-5 ) );
+        }
+
+#if defined( RAYTRACE_X86 )
+        std::vector< gm::Vec3f > batchDirections( samples.size() );
+        raytrace::UniformSphereSamplesSSE2( samples.data(), samples.size(), batchDirections.data() );
+        CHECK( std::memcmp( batchDirections.data(), directions.data(), sizeof( gm::Vec3f ) * directions.size() ) ==
+               0 );
+#endif
+    }
+}
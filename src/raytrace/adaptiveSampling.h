@@ -0,0 +1,150 @@
+#pragma once
+
+/// \file raytrace/adaptiveSampling.h
+///
+/// Per-pixel sample statistics, for terminating pixel sampling once the estimate has converged.
+
+#include <raytrace/imageBuffer.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/functions/linearInterpolation.h>
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <cmath>
+
+RAYTRACE_NS_OPEN
+
+/// \class AdaptiveSamplingSettings
+///
+/// Controls the number of samples taken per pixel.
+///
+/// Each pixel takes at least \ref m_minSamplesPerPixel, and at most \ref m_maxSamplesPerPixel samples.
+/// In between, sampling stops once the estimated relative error of the pixel luminance, at 95% confidence,
+/// falls below \ref m_errorThreshold.  Equal minimum and maximum counts produce fixed-rate sampling.
+class AdaptiveSamplingSettings
+{
+public:
+    /// Minimum number of samples per-pixel, before convergence is tested.
+    int m_minSamplesPerPixel = 100;
+
+    /// Maximum number of samples per-pixel.
+    int m_maxSamplesPerPixel = 100;
+
+    /// Relative error of the pixel luminance, below which sampling stops.
+    float m_errorThreshold = 0.05f;
+};
+
+/// \class SampleStatistics
+///
+/// Running mean of the color samples of a pixel, with the mean and variance of their luminance, computed
+/// incrementally with Welford's algorithm.
+class SampleStatistics
+{
+public:
+    /// Add a color sample.
+    ///
+    /// \param i_sample The sample color.
+    inline void Add( const gm::Vec3f& i_sample )
+    {
+        m_count++;
+        m_mean += ( i_sample - m_mean ) / static_cast< float >( m_count );
+
+        const float luminance = Luminance( i_sample );
+        const float delta     = luminance - m_luminanceMean;
+        m_luminanceMean += delta / static_cast< float >( m_count );
+        m_luminanceSquaredDeviations += delta * ( luminance - m_luminanceMean );
+    }
+
+    /// Get the number of samples added.
+    inline int Count() const
+    {
+        return m_count;
+    }
+
+    /// Get the mean sample color.
+    inline const gm::Vec3f& Mean() const
+    {
+        return m_mean;
+    }
+
+    /// Get the unbiased sample variance of the luminance.
+    inline float LuminanceVariance() const
+    {
+        return m_count > 1 ? m_luminanceSquaredDeviations / static_cast< float >( m_count - 1 ) : 0.0f;
+    }
+
+    /// Test whether enough samples have been taken, according to \p i_settings.
+    ///
+    /// \param i_settings The adaptive sampling settings.
+    ///
+    /// \return true if sampling should stop.
+    inline bool IsComplete( const AdaptiveSamplingSettings& i_settings ) const
+    {
+        if ( m_count >= i_settings.m_maxSamplesPerPixel )
+        {
+            return true;
+        }
+
+        if ( m_count < std::max( i_settings.m_minSamplesPerPixel, 2 ) )
+        {
+            return false;
+        }
+
+        // Half-width of the 95% confidence interval of the mean, relative to the mean.  Near-black pixels are
+        // measured against a floor, rather than chasing a relative error which is imperceptible.
+        const float minLuminance  = c_minLuminance;
+        const float standardError = std::sqrt( LuminanceVariance() / static_cast< float >( m_count ) );
+        const float tolerance     = i_settings.m_errorThreshold * std::max( m_luminanceMean, minLuminance );
+        return c_confidenceScale * standardError <= tolerance;
+    }
+
+    /// Compute the luminance of a linear RGB color, with Rec. 709 weights.
+    static inline float Luminance( const gm::Vec3f& i_color )
+    {
+        return 0.2126f * i_color[ 0 ] + 0.7152f * i_color[ 1 ] + 0.0722f * i_color[ 2 ];
+    }
+
+private:
+    // Two-sided 95% quantile of the normal distribution.
+    static constexpr float c_confidenceScale = 1.96f;
+
+    // Luminance floor for the relative error test.
+    static constexpr float c_minLuminance = 0.01f;
+
+    int       m_count = 0;
+    gm::Vec3f m_mean;
+    float     m_luminanceMean              = 0.0f;
+    float     m_luminanceSquaredDeviations = 0.0f;
+};
+
+/// Map per-pixel sample counts to a heat map image, from blue for \p i_minSamples, through green, to red for
+/// \p i_maxSamples.
+///
+/// \param i_sampleCounts The number of samples taken per-pixel.
+/// \param i_minSamples The sample count mapped to the coolest color.
+/// \param i_maxSamples The sample count mapped to the hottest color.
+/// \param o_image The image to write the heat map into.  It is resized to match \p i_sampleCounts.
+inline void ComputeSampleCountHeatMap( const ImageBuffer< int >& i_sampleCounts,
+                                       int                       i_minSamples,
+                                       int                       i_maxSamples,
+                                       RGBImageBuffer&           o_image )
+{
+    const gm::Vec3f cold( 0.0f, 0.0f, 1.0f );
+    const gm::Vec3f warm( 0.0f, 1.0f, 0.0f );
+    const gm::Vec3f hot( 1.0f, 0.0f, 0.0f );
+    const float     sampleRange = static_cast< float >( std::max( i_maxSamples - i_minSamples, 1 ) );
+
+    o_image.Resize( i_sampleCounts.Width(), i_sampleCounts.Height() );
+    for ( const gm::Vec2i& pixelCoord : i_sampleCounts.Extent() )
+    {
+        float weight = ( i_sampleCounts( pixelCoord.X(), pixelCoord.Y() ) - i_minSamples ) / sampleRange;
+        weight       = std::min( std::max( weight, 0.0f ), 1.0f );
+
+        o_image( pixelCoord.X(), pixelCoord.Y() ) = weight < 0.5f
+                                                        ? gm::LinearInterpolation( cold, warm, weight * 2.0f )
+                                                        : gm::LinearInterpolation( warm, hot, weight * 2.0f - 1.0f );
+    }
+}
+
+RAYTRACE_NS_CLOSE
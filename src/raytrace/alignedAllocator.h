@@ -0,0 +1,101 @@
+#pragma once
+
+/// \file raytrace/alignedAllocator.h
+///
+/// Allocator producing memory aligned for vector (SIMD) loads & stores.
+
+#include <raytrace/raytrace.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined( _WIN32 )
+#include <malloc.h>
+#endif
+
+RAYTRACE_NS_OPEN
+
+/// \var c_simdAlignment
+///
+/// Byte alignment suitable for the widest vector registers used by this library (256-bit AVX).
+constexpr size_t c_simdAlignment = 32;
+
+/// \var c_cacheLineSize
+///
+/// Byte size of a cache line, for separating data written concurrently by different threads.
+constexpr size_t c_cacheLineSize = 64;
+
+/// \class AlignedAllocator
+///
+/// A standard library compatible allocator, where each allocation is aligned to \p Alignment bytes.
+///
+/// \tparam ValueT The allocated value type.
+/// \tparam Alignment The byte alignment of each allocation.  Must be a power of two.
+template < typename ValueT, size_t Alignment = c_simdAlignment >
+class AlignedAllocator
+{
+public:
+    using value_type = ValueT;
+
+    template < typename OtherValueT >
+    struct rebind
+    {
+        using other = AlignedAllocator< OtherValueT, Alignment >;
+    };
+
+    AlignedAllocator() = default;
+
+    template < typename OtherValueT >
+    inline AlignedAllocator( const AlignedAllocator< OtherValueT, Alignment >& )
+    {
+    }
+
+    inline ValueT* allocate( size_t i_count )
+    {
+        void* memory = nullptr;
+#if defined( _WIN32 )
+        memory = _aligned_malloc( i_count * sizeof( ValueT ), Alignment );
+#else
+        if ( posix_memalign( &memory, Alignment, i_count * sizeof( ValueT ) ) != 0 )
+        {
+            memory = nullptr;
+        }
+#endif
+        if ( memory == nullptr )
+        {
+            throw std::bad_alloc();
+        }
+
+        return static_cast< ValueT* >( memory );
+    }
+
+    inline void deallocate( ValueT* i_memory, size_t )
+    {
+#if defined( _WIN32 )
+        _aligned_free( i_memory );
+#else
+        free( i_memory );
+#endif
+    }
+
+    template < typename OtherValueT >
+    inline bool operator==( const AlignedAllocator< OtherValueT, Alignment >& ) const
+    {
+        return true;
+    }
+
+    template < typename OtherValueT >
+    inline bool operator!=( const AlignedAllocator< OtherValueT, Alignment >& ) const
+    {
+        return false;
+    }
+};
+
+/// \typedef AlignedFloatArray
+///
+/// Contiguous float storage, aligned for vector loads.
+using AlignedFloatArray = std::vector< float, AlignedAllocator< float > >;
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,664 @@
+/// \file raytrace/bvh.cpp
+
+#include <raytrace/bvh.h>
+
+#include <raytrace/tileRenderer.h>
+#include <raytrace/workStealingScheduler.h>
+
+#include <gm/functions/expand.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+RAYTRACE_NS_OPEN
+
+/// \var c_bucketCount
+///
+/// The number of buckets to evaluate the SAH split cost with, per-axis.
+static constexpr int c_bucketCount = 16;
+
+/// \var c_traversalCost
+///
+/// The cost of traversing an interior node, relative to a single scene object intersection.
+static constexpr float c_traversalCost = 0.125f;
+
+/// \var c_minSubtreeTaskSize
+///
+/// The minimum number of objects under a subtree which is built as a separate task.
+static constexpr size_t c_minSubtreeTaskSize = 1024;
+
+/// \var c_subtreeTasksPerThread
+///
+/// The number of subtree tasks to split the top levels into, per-thread, such that threads which finish
+/// small subtrees early can steal the remaining ones.
+static constexpr size_t c_subtreeTasksPerThread = 8;
+
+/// \var c_mortonBitsPerAxis
+///
+/// The number of bits of each centroid coordinate, interleaved into a 30-bit Morton code.
+static constexpr int c_mortonBitsPerAxis = 10;
+
+/// \var c_radixBits
+///
+/// The number of bits sorted per radix sort pass.
+static constexpr int c_radixBits = 10;
+
+/// \var c_radixBucketCount
+///
+/// The number of buckets per radix sort pass.
+static constexpr size_t c_radixBucketCount = 1 << c_radixBits;
+
+/// \class ObjectInfo
+///
+/// Per-object information used during the build.
+class ObjectInfo
+{
+public:
+    gm::Vec3fRange m_bounds;
+    gm::Vec3f      m_centroid;
+    size_t         m_index = 0;
+};
+
+/// \class MortonObject
+///
+/// An object index, keyed by the Morton code of its centroid.
+class MortonObject
+{
+public:
+    uint32_t m_code  = 0;
+    uint32_t m_index = 0;
+};
+
+/// \class SubtreeTask
+///
+/// A range of objects whose subtree is built by a single task.
+class SubtreeTask
+{
+public:
+    size_t m_begin = 0;
+    size_t m_end   = 0;
+    int    m_depth = 0;
+};
+
+/// \class TopLevelNode
+///
+/// A node among the top levels of the hierarchy, built serially before the subtree tasks.
+class TopLevelNode
+{
+public:
+    /// The subtree task which builds this node, or -1 for an interior node.
+    int m_task = -1;
+
+    /// The child top level nodes, of an interior node.
+    int m_children[ 2 ] = { 0, 0 };
+
+    /// The axis which the child nodes were split along.
+    int m_splitAxis = 0;
+};
+
+/// Compute the range of the chunk \p i_chunkIndex, when splitting \p i_count elements into \p i_chunkCount
+/// contiguous chunks.
+static void ChunkRange( size_t i_count, size_t i_chunkCount, size_t i_chunkIndex, size_t& o_begin, size_t& o_end )
+{
+    o_begin = ( i_count * i_chunkIndex ) / i_chunkCount;
+    o_end   = ( i_count * ( i_chunkIndex + 1 ) ) / i_chunkCount;
+}
+
+static gm::Vec3f Centroid( const gm::Vec3fRange& i_bounds )
+{
+    return ( i_bounds.Min() + i_bounds.Max() ) * 0.5f;
+}
+
+/// Compute the bucket which the centroid \p i_centroid falls into, along \p i_axis.
+static int BucketIndex( const gm::Vec3f& i_centroid, const gm::Vec3fRange& i_centroidBounds, int i_axis )
+{
+    float extent = i_centroidBounds.Max()[ i_axis ] - i_centroidBounds.Min()[ i_axis ];
+    int   bucket =
+        static_cast< int >( c_bucketCount * ( i_centroid[ i_axis ] - i_centroidBounds.Min()[ i_axis ] ) / extent );
+    return std::min( bucket, c_bucketCount - 1 );
+}
+
+/// Spread the lower 10 bits of \p i_value, such that there are two zero bits between each.
+static uint32_t SpreadBits( uint32_t i_value )
+{
+    i_value = ( i_value * 0x00010001u ) & 0xFF0000FFu;
+    i_value = ( i_value * 0x00000101u ) & 0x0F00F00Fu;
+    i_value = ( i_value * 0x00000011u ) & 0xC30C30C3u;
+    i_value = ( i_value * 0x00000005u ) & 0x49249249u;
+    return i_value;
+}
+
+/// Compute the 30-bit Morton code of \p i_point, interleaving the bits of each axis with X as the most
+/// significant.
+///
+/// \param i_point The point, normalized to [0, 1] on each axis.
+static uint32_t MortonCode( const gm::Vec3f& i_point )
+{
+    const float scale = static_cast< float >( 1 << c_mortonBitsPerAxis );
+
+    uint32_t code = 0;
+    for ( int axis = 0; axis < 3; ++axis )
+    {
+        float quantized = std::min( std::max( i_point[ axis ] * scale, 0.0f ), scale - 1.0f );
+        code |= SpreadBits( static_cast< uint32_t >( quantized ) ) << ( 2 - axis );
+    }
+
+    return code;
+}
+
+/// \class BinnedSAHSplitter
+///
+/// Splits a range of objects by the lowest cost bucket boundary, under the surface area heuristic.
+class BinnedSAHSplitter
+{
+public:
+    inline explicit BinnedSAHSplitter( int i_maxLeafSize )
+        : m_maxLeafSize( i_maxLeafSize )
+    {
+    }
+
+    /// Split the objects within [i_begin, i_end), partitioning them in place.
+    ///
+    /// \param io_objectInfos The objects.
+    /// \param i_begin The first object of the range.
+    /// \param i_end One past the last object of the range.
+    /// \param o_middle The first object of the second child.
+    /// \param o_splitAxis The axis which the objects were split along.
+    ///
+    /// \return false if the objects should be stored in a leaf instead.
+    bool operator()( std::vector< ObjectInfo >& io_objectInfos,
+                     size_t                     i_begin,
+                     size_t                     i_end,
+                     size_t&                    o_middle,
+                     int&                       o_splitAxis ) const
+    {
+        const int objectCount = static_cast< int >( i_end - i_begin );
+        if ( objectCount <= 1 )
+        {
+            return false;
+        }
+
+        gm::Vec3fRange bounds;
+        gm::Vec3fRange centroidBounds;
+        for ( size_t objectIndex = i_begin; objectIndex < i_end; ++objectIndex )
+        {
+            bounds         = gm::Expand( bounds, io_objectInfos[ objectIndex ].m_bounds );
+            centroidBounds = gm::Expand( centroidBounds, io_objectInfos[ objectIndex ].m_centroid );
+        }
+
+        // Find the lowest cost split, across all axes.
+        float bestCost   = std::numeric_limits< float >::max();
+        int   bestAxis   = -1;
+        int   bestBucket = 0;
+        for ( int axis = 0; axis < 3; ++axis )
+        {
+            if ( centroidBounds.Max()[ axis ] <= centroidBounds.Min()[ axis ] )
+            {
+                // All centroids are coincident along this axis.
+                continue;
+            }
+
+            _Bucket buckets[ c_bucketCount ];
+            for ( size_t objectIndex = i_begin; objectIndex < i_end; ++objectIndex )
+            {
+                const ObjectInfo& objectInfo = io_objectInfos[ objectIndex ];
+                _Bucket&          bucket     = buckets[ BucketIndex( objectInfo.m_centroid, centroidBounds, axis ) ];
+                bucket.m_bounds              = gm::Expand( bucket.m_bounds, objectInfo.m_bounds );
+                bucket.m_objectCount++;
+            }
+
+            // Sweep from the right to accumulate the area & count of each candidate's right side.
+            float rightAreas[ c_bucketCount ];
+            int   rightCounts[ c_bucketCount ];
+            {
+                gm::Vec3fRange rightBounds;
+                int            rightCount = 0;
+                for ( int bucketIndex = c_bucketCount - 1; bucketIndex > 0; --bucketIndex )
+                {
+                    rightBounds                = gm::Expand( rightBounds, buckets[ bucketIndex ].m_bounds );
+                    rightCount                += buckets[ bucketIndex ].m_objectCount;
+                    rightAreas[ bucketIndex ]  = BVH::SurfaceArea( rightBounds );
+                    rightCounts[ bucketIndex ] = rightCount;
+                }
+            }
+
+            // Sweep from the left, evaluating the cost of splitting after each bucket.
+            gm::Vec3fRange leftBounds;
+            int            leftCount = 0;
+            for ( int bucketIndex = 0; bucketIndex < c_bucketCount - 1; ++bucketIndex )
+            {
+                leftBounds = gm::Expand( leftBounds, buckets[ bucketIndex ].m_bounds );
+                leftCount += buckets[ bucketIndex ].m_objectCount;
+                if ( leftCount == 0 || rightCounts[ bucketIndex + 1 ] == 0 )
+                {
+                    continue;
+                }
+
+                float cost = leftCount * BVH::SurfaceArea( leftBounds ) +
+                             rightCounts[ bucketIndex + 1 ] * rightAreas[ bucketIndex + 1 ];
+                if ( cost < bestCost )
+                {
+                    bestCost   = cost;
+                    bestAxis   = axis;
+                    bestBucket = bucketIndex;
+                }
+            }
+        }
+
+        // Normalize the split cost by the parent area, to compare against the cost of a leaf.
+        float boundsArea = BVH::SurfaceArea( bounds );
+        float splitCost  = boundsArea > 0.0f ? c_traversalCost + bestCost / boundsArea : bestCost;
+        if ( bestAxis < 0 || ( objectCount <= m_maxLeafSize && splitCost >= static_cast< float >( objectCount ) ) )
+        {
+            return false;
+        }
+
+        // Partition the objects by the chosen bucket split.
+        auto middleIt = std::partition( io_objectInfos.begin() + i_begin,
+                                        io_objectInfos.begin() + i_end,
+                                        [ & ]( const ObjectInfo& i_objectInfo ) {
+                                            return BucketIndex( i_objectInfo.m_centroid, centroidBounds, bestAxis ) <=
+                                                   bestBucket;
+                                        } );
+        o_middle    = static_cast< size_t >( middleIt - io_objectInfos.begin() );
+        o_splitAxis = bestAxis;
+        return true;
+    }
+
+private:
+    // Accumulated bounds & counts of objects whose centroids fall into a single bucket.
+    struct _Bucket
+    {
+        gm::Vec3fRange m_bounds;
+        int            m_objectCount = 0;
+    };
+
+    int m_maxLeafSize = 4;
+};
+
+/// \class MortonSplitter
+///
+/// Splits a range of objects, sorted by Morton code, at the highest bit which differs across the range.
+/// This is equivalent to splitting the centroid bounds at the midpoint of a power-of-two octree cell.
+class MortonSplitter
+{
+public:
+    /// \param i_mortonCodes The Morton codes of the objects, in the same order.
+    /// \param i_maxLeafSize The maximum number of objects to store in a leaf node.
+    inline MortonSplitter( const std::vector< uint32_t >& i_mortonCodes, int i_maxLeafSize )
+        : m_mortonCodes( i_mortonCodes )
+        , m_maxLeafSize( i_maxLeafSize )
+    {
+    }
+
+    /// See \ref BinnedSAHSplitter::operator().  The objects are not re-ordered.
+    bool operator()( std::vector< ObjectInfo >& io_objectInfos,
+                     size_t                     i_begin,
+                     size_t                     i_end,
+                     size_t&                    o_middle,
+                     int&                       o_splitAxis ) const
+    {
+        ( void ) io_objectInfos;
+        if ( i_end - i_begin <= static_cast< size_t >( m_maxLeafSize ) )
+        {
+            return false;
+        }
+
+        const uint32_t firstCode = m_mortonCodes[ i_begin ];
+        const uint32_t lastCode  = m_mortonCodes[ i_end - 1 ];
+        if ( firstCode == lastCode )
+        {
+            // Centroids within the same cell cannot be told apart, thus split the range in half.
+            o_middle    = i_begin + ( i_end - i_begin ) / 2;
+            o_splitAxis = 0;
+            return true;
+        }
+
+        int splitBit = 31;
+        while ( ( ( firstCode ^ lastCode ) >> splitBit ) == 0 )
+        {
+            --splitBit;
+        }
+
+        // The codes are sorted & share all bits above the split bit, thus those with it unset come first.
+        const uint32_t splitMask = 1u << splitBit;
+        auto           middleIt  = std::partition_point( m_mortonCodes.begin() + i_begin,
+                                                  m_mortonCodes.begin() + i_end,
+                                                  [ & ]( uint32_t i_code ) { return ( i_code & splitMask ) == 0; } );
+        o_middle                 = static_cast< size_t >( middleIt - m_mortonCodes.begin() );
+        o_splitAxis              = 2 - splitBit % 3;
+        return true;
+    }
+
+private:
+    const std::vector< uint32_t >& m_mortonCodes;
+    int                            m_maxLeafSize = 4;
+};
+
+/// Sort the objects along a Z-order curve, by the Morton codes of their centroids normalized to the centroid
+/// bounds.  Morton codes are computed in parallel, then sorted with a parallel, least significant digit first
+/// radix sort.
+///
+/// \param io_objectInfos The objects to sort.
+/// \param io_scheduler The scheduler to execute parallel work with.
+///
+/// \return The sorted Morton codes, in the order of \p io_objectInfos.
+static std::vector< uint32_t > SortByMortonCode( std::vector< ObjectInfo >& io_objectInfos,
+                                                 WorkStealingScheduler&     io_scheduler )
+{
+    const size_t objectCount = io_objectInfos.size();
+    const size_t chunkCount  = std::max< size_t >(
+        std::min( static_cast< size_t >( io_scheduler.ThreadCount() ), objectCount / c_minSubtreeTaskSize ), 1 );
+
+    gm::Vec3fRange centroidBounds;
+    for ( const ObjectInfo& objectInfo : io_objectInfos )
+    {
+        centroidBounds = gm::Expand( centroidBounds, objectInfo.m_centroid );
+    }
+
+    gm::Vec3f inverseExtent;
+    for ( int axis = 0; axis < 3; ++axis )
+    {
+        const float extent    = centroidBounds.Max()[ axis ] - centroidBounds.Min()[ axis ];
+        inverseExtent[ axis ] = extent > 0.0f ? 1.0f / extent : 0.0f;
+    }
+
+    std::vector< MortonObject > mortonObjects( objectCount );
+    io_scheduler.Run( chunkCount, [ & ]( size_t i_chunkIndex ) {
+        size_t begin, end;
+        ChunkRange( objectCount, chunkCount, i_chunkIndex, begin, end );
+        for ( size_t objectIndex = begin; objectIndex < end; ++objectIndex )
+        {
+            gm::Vec3f normalized = io_objectInfos[ objectIndex ].m_centroid - centroidBounds.Min();
+            for ( int axis = 0; axis < 3; ++axis )
+            {
+                normalized[ axis ] *= inverseExtent[ axis ];
+            }
+
+            mortonObjects[ objectIndex ].m_code  = MortonCode( normalized );
+            mortonObjects[ objectIndex ].m_index = static_cast< uint32_t >( objectIndex );
+        }
+    } );
+
+    // Each pass counts the digits of each chunk, then scatters the chunks into disjoint, stable output ranges.
+    std::vector< MortonObject > scratch( objectCount );
+    std::vector< size_t >       offsets( chunkCount * c_radixBucketCount );
+    for ( int shift = 0; shift < 3 * c_mortonBitsPerAxis; shift += c_radixBits )
+    {
+        const uint32_t digitMask = static_cast< uint32_t >( c_radixBucketCount - 1 );
+        std::fill( offsets.begin(), offsets.end(), 0 );
+        io_scheduler.Run( chunkCount, [ & ]( size_t i_chunkIndex ) {
+            size_t begin, end;
+            ChunkRange( objectCount, chunkCount, i_chunkIndex, begin, end );
+            size_t* chunkCounts = &offsets[ i_chunkIndex * c_radixBucketCount ];
+            for ( size_t objectIndex = begin; objectIndex < end; ++objectIndex )
+            {
+                chunkCounts[ ( mortonObjects[ objectIndex ].m_code >> shift ) & digitMask ]++;
+            }
+        } );
+
+        // Exclusive prefix sum, ordered by digit then chunk.
+        size_t offset = 0;
+        for ( size_t digit = 0; digit < c_radixBucketCount; ++digit )
+        {
+            for ( size_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex )
+            {
+                size_t&      chunkOffset = offsets[ chunkIndex * c_radixBucketCount + digit ];
+                const size_t count       = chunkOffset;
+                chunkOffset              = offset;
+                offset += count;
+            }
+        }
+
+        io_scheduler.Run( chunkCount, [ & ]( size_t i_chunkIndex ) {
+            size_t begin, end;
+            ChunkRange( objectCount, chunkCount, i_chunkIndex, begin, end );
+            size_t* chunkOffsets = &offsets[ i_chunkIndex * c_radixBucketCount ];
+            for ( size_t objectIndex = begin; objectIndex < end; ++objectIndex )
+            {
+                const MortonObject& mortonObject = mortonObjects[ objectIndex ];
+                scratch[ chunkOffsets[ ( mortonObject.m_code >> shift ) & digitMask ]++ ] = mortonObject;
+            }
+        } );
+
+        mortonObjects.swap( scratch );
+    }
+
+    std::vector< ObjectInfo > sortedObjectInfos( objectCount );
+    std::vector< uint32_t >   mortonCodes( objectCount );
+    for ( size_t objectIndex = 0; objectIndex < objectCount; ++objectIndex )
+    {
+        sortedObjectInfos[ objectIndex ] = io_objectInfos[ mortonObjects[ objectIndex ].m_index ];
+        mortonCodes[ objectIndex ]       = mortonObjects[ objectIndex ].m_code;
+    }
+
+    io_objectInfos.swap( sortedObjectInfos );
+    return mortonCodes;
+}
+
+/// Recursively build the subtree over the objects within [i_begin, i_end), in depth-first order.
+///
+/// \tparam SplitterT See \ref BinnedSAHSplitter.
+///
+/// \return The index of the subtree root, within \p o_nodes.
+template < typename SplitterT >
+static int BuildSubtree( const SplitterT&           i_splitter,
+                         std::vector< ObjectInfo >& io_objectInfos,
+                         size_t                     i_begin,
+                         size_t                     i_end,
+                         int                        i_depth,
+                         std::vector< BVH::Node >&  o_nodes )
+{
+    const int nodeIndex = static_cast< int >( o_nodes.size() );
+    o_nodes.push_back( BVH::Node() );
+
+    size_t middle    = 0;
+    int    splitAxis = 0;
+    if ( i_depth + 1 < BVH::c_maxDepth && i_splitter( io_objectInfos, i_begin, i_end, middle, splitAxis ) )
+    {
+        BuildSubtree( i_splitter, io_objectInfos, i_begin, middle, i_depth + 1, o_nodes );
+        const int secondChildIndex = BuildSubtree( i_splitter, io_objectInfos, middle, i_end, i_depth + 1, o_nodes );
+
+        BVH::Node& node  = o_nodes[ nodeIndex ];
+        node.m_bounds    = gm::Expand( o_nodes[ nodeIndex + 1 ].m_bounds, o_nodes[ secondChildIndex ].m_bounds );
+        node.m_index     = secondChildIndex;
+        node.m_splitAxis = splitAxis;
+        return nodeIndex;
+    }
+
+    // Create a leaf.
+    BVH::Node& node = o_nodes[ nodeIndex ];
+    for ( size_t objectIndex = i_begin; objectIndex < i_end; ++objectIndex )
+    {
+        node.m_bounds = gm::Expand( node.m_bounds, io_objectInfos[ objectIndex ].m_bounds );
+    }
+    node.m_index       = static_cast< int >( i_begin );
+    node.m_objectCount = static_cast< int >( i_end - i_begin );
+    return nodeIndex;
+}
+
+/// Recursively split the top levels of the hierarchy, until the object ranges are no larger than
+/// \p i_maxTaskSize.  Each such range becomes a subtree task.
+///
+/// \return The index of the top level node, within \p io_topLevelNodes.
+template < typename SplitterT >
+static int BuildTopLevels( const SplitterT&             i_splitter,
+                           std::vector< ObjectInfo >&   io_objectInfos,
+                           size_t                       i_begin,
+                           size_t                       i_end,
+                           int                          i_depth,
+                           size_t                       i_maxTaskSize,
+                           std::vector< TopLevelNode >& io_topLevelNodes,
+                           std::vector< SubtreeTask >&  io_tasks )
+{
+    const int topLevelIndex = static_cast< int >( io_topLevelNodes.size() );
+    io_topLevelNodes.push_back( TopLevelNode() );
+
+    size_t middle    = 0;
+    int    splitAxis = 0;
+    if ( i_end - i_begin > i_maxTaskSize && i_depth + 1 < BVH::c_maxDepth &&
+         i_splitter( io_objectInfos, i_begin, i_end, middle, splitAxis ) )
+    {
+        const int firstChild  = BuildTopLevels(
+            i_splitter, io_objectInfos, i_begin, middle, i_depth + 1, i_maxTaskSize, io_topLevelNodes, io_tasks );
+        const int secondChild = BuildTopLevels(
+            i_splitter, io_objectInfos, middle, i_end, i_depth + 1, i_maxTaskSize, io_topLevelNodes, io_tasks );
+
+        TopLevelNode& topLevelNode   = io_topLevelNodes[ topLevelIndex ];
+        topLevelNode.m_children[ 0 ] = firstChild;
+        topLevelNode.m_children[ 1 ] = secondChild;
+        topLevelNode.m_splitAxis     = splitAxis;
+        return topLevelIndex;
+    }
+
+    SubtreeTask task;
+    task.m_begin                             = i_begin;
+    task.m_end                               = i_end;
+    task.m_depth                             = i_depth;
+    io_topLevelNodes[ topLevelIndex ].m_task = static_cast< int >( io_tasks.size() );
+    io_tasks.push_back( task );
+    return topLevelIndex;
+}
+
+/// Recursively append the top level node \p i_topLevelIndex and its descendants to \p o_nodes, in depth-first
+/// order, splicing in the nodes of the subtree tasks.
+///
+/// \return The index of the node, within \p o_nodes.
+static int EmitTopLevels( const std::vector< TopLevelNode >&             i_topLevelNodes,
+                          int                                            i_topLevelIndex,
+                          const std::vector< std::vector< BVH::Node > >& i_subtrees,
+                          std::vector< BVH::Node >&                      o_nodes )
+{
+    const TopLevelNode& topLevelNode = i_topLevelNodes[ i_topLevelIndex ];
+    const int           nodeIndex    = static_cast< int >( o_nodes.size() );
+    if ( topLevelNode.m_task >= 0 )
+    {
+        // Subtree node indices are relative to the subtree root.
+        for ( BVH::Node node : i_subtrees[ topLevelNode.m_task ] )
+        {
+            if ( node.m_objectCount == 0 )
+            {
+                node.m_index += nodeIndex;
+            }
+            o_nodes.push_back( node );
+        }
+        return nodeIndex;
+    }
+
+    o_nodes.push_back( BVH::Node() );
+    EmitTopLevels( i_topLevelNodes, topLevelNode.m_children[ 0 ], i_subtrees, o_nodes );
+    const int secondChildIndex = EmitTopLevels( i_topLevelNodes, topLevelNode.m_children[ 1 ], i_subtrees, o_nodes );
+
+    BVH::Node& node  = o_nodes[ nodeIndex ];
+    node.m_bounds    = gm::Expand( o_nodes[ nodeIndex + 1 ].m_bounds, o_nodes[ secondChildIndex ].m_bounds );
+    node.m_index     = secondChildIndex;
+    node.m_splitAxis = topLevelNode.m_splitAxis;
+    return nodeIndex;
+}
+
+/// Build the hierarchy over \p io_objectInfos, re-ordering them such that each leaf references a contiguous
+/// range.  The top levels are split serially, then the subtrees beneath are built in parallel.
+///
+/// \tparam SplitterT See \ref BinnedSAHSplitter.
+template < typename SplitterT >
+static void BuildNodes( const SplitterT&           i_splitter,
+                        std::vector< ObjectInfo >& io_objectInfos,
+                        WorkStealingScheduler&     io_scheduler,
+                        std::vector< BVH::Node >&  o_nodes )
+{
+    const size_t objectCount = io_objectInfos.size();
+    const size_t threadCount = static_cast< size_t >( io_scheduler.ThreadCount() );
+
+    // A single thread builds the whole hierarchy as one task.
+    size_t maxTaskSize = objectCount;
+    if ( threadCount > 1 )
+    {
+        maxTaskSize = std::max( objectCount / ( threadCount * c_subtreeTasksPerThread ), c_minSubtreeTaskSize );
+    }
+
+    std::vector< TopLevelNode > topLevelNodes;
+    std::vector< SubtreeTask >  tasks;
+    BuildTopLevels( i_splitter, io_objectInfos, 0, objectCount, 0, maxTaskSize, topLevelNodes, tasks );
+
+    // Each task partitions a disjoint range of the objects.
+    std::vector< std::vector< BVH::Node > > subtrees( tasks.size() );
+    io_scheduler.Run( tasks.size(), [ & ]( size_t i_taskIndex ) {
+        const SubtreeTask& task = tasks[ i_taskIndex ];
+        subtrees[ i_taskIndex ].reserve( 2 * ( task.m_end - task.m_begin ) );
+        BuildSubtree( i_splitter, io_objectInfos, task.m_begin, task.m_end, task.m_depth, subtrees[ i_taskIndex ] );
+    } );
+
+    o_nodes.reserve( 2 * objectCount );
+    EmitTopLevels( topLevelNodes, 0, subtrees, o_nodes );
+}
+
+/// Compute the expected cost of intersecting a ray with the hierarchy, by the surface area heuristic.
+static float ComputeSAHCost( const std::vector< BVH::Node >& i_nodes )
+{
+    float cost = 0.0f;
+    for ( const BVH::Node& node : i_nodes )
+    {
+        const float intersectionCost =
+            node.m_objectCount > 0 ? static_cast< float >( node.m_objectCount ) : c_traversalCost;
+        cost += intersectionCost * BVH::SurfaceArea( node.m_bounds );
+    }
+
+    const float rootArea = BVH::SurfaceArea( i_nodes[ 0 ].m_bounds );
+    return rootArea > 0.0f ? cost / rootArea : cost;
+}
+
+BVH::BVH( SceneObjectPtrs&& i_sceneObjects, const BVHBuildSettings& i_settings )
+{
+    using Clock = std::chrono::steady_clock;
+
+    if ( i_sceneObjects.empty() )
+    {
+        return;
+    }
+
+    const Clock::time_point buildBegin = Clock::now();
+
+    std::vector< ObjectInfo > objectInfos( i_sceneObjects.size() );
+    for ( size_t objectIndex = 0; objectIndex < i_sceneObjects.size(); ++objectIndex )
+    {
+        objectInfos[ objectIndex ].m_bounds   = i_sceneObjects[ objectIndex ]->BoundingBox();
+        objectInfos[ objectIndex ].m_centroid = Centroid( objectInfos[ objectIndex ].m_bounds );
+        objectInfos[ objectIndex ].m_index    = objectIndex;
+    }
+
+    WorkStealingScheduler scheduler( ResolveThreadCount( i_settings.m_threadCount ) );
+    switch ( i_settings.m_method )
+    {
+    case BVHBuildMethod::BinnedSAH:
+        BuildNodes( BinnedSAHSplitter( i_settings.m_maxLeafSize ), objectInfos, scheduler, m_nodes );
+        break;
+    case BVHBuildMethod::LBVH:
+    {
+        const std::vector< uint32_t > mortonCodes = SortByMortonCode( objectInfos, scheduler );
+        BuildNodes( MortonSplitter( mortonCodes, i_settings.m_maxLeafSize ), objectInfos, scheduler, m_nodes );
+        break;
+    }
+    }
+
+    // Re-order the scene objects to match the leaf ordering.
+    m_sceneObjects.reserve( i_sceneObjects.size() );
+    for ( const ObjectInfo& objectInfo : objectInfos )
+    {
+        m_sceneObjects.push_back( std::move( i_sceneObjects[ objectInfo.m_index ] ) );
+    }
+    i_sceneObjects.clear();
+
+    m_buildStatistics.m_buildSeconds = std::chrono::duration< double >( Clock::now() - buildBegin ).count();
+    m_buildStatistics.m_sahCost      = ComputeSAHCost( m_nodes );
+    m_buildStatistics.m_nodeCount    = m_nodes.size();
+    for ( const Node& node : m_nodes )
+    {
+        m_buildStatistics.m_leafCount += node.m_objectCount > 0 ? 1 : 0;
+    }
+
+    CompileMaterials( m_materials );
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,266 @@
+#pragma once
+
+/// \file raytrace/bvh.h
+///
+/// Bounding volume hierarchy (BVH) acceleration structure over scene objects.
+
+#include <raytrace/hitRecord.h>
+#include <raytrace/materialTable.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/functions/rayAABBIntersection.h>
+#include <gm/types/floatRange.h>
+#include <gm/types/vec3fRange.h>
+
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \enum BVHBuildMethod
+///
+/// Algorithm used to build a \ref BVH.
+enum class BVHBuildMethod
+{
+    /// Top-down splits chosen by the surface area heuristic, evaluated over buckets of object centroids.
+    /// Slower to build, faster to trace.
+    BinnedSAH,
+
+    /// Linear BVH: objects are sorted along a Z-order curve by the Morton codes of their centroids, then split
+    /// at the highest differing bit of the codes.  Faster to build, slower to trace.
+    LBVH
+};
+
+/// \class BVHBuildSettings
+///
+/// Parameters of a \ref BVH build.
+class BVHBuildSettings
+{
+public:
+    /// The build algorithm.
+    BVHBuildMethod m_method = BVHBuildMethod::BinnedSAH;
+
+    /// The maximum number of scene objects to store in a leaf node.
+    int m_maxLeafSize = 4;
+
+    /// Number of worker threads.  See \ref ResolveThreadCount.
+    int m_threadCount = 0;
+};
+
+/// \class BVHBuildStatistics
+///
+/// Build time & quality of a \ref BVH.
+class BVHBuildStatistics
+{
+public:
+    /// Wall time of the build, in seconds.
+    double m_buildSeconds = 0.0;
+
+    /// Expected cost of intersecting a ray with the hierarchy, by the surface area heuristic, relative to the cost
+    /// of intersecting a single scene object.  Lower is better.
+    float m_sahCost = 0.0f;
+
+    /// The number of nodes in the hierarchy.
+    size_t m_nodeCount = 0;
+
+    /// The number of leaf nodes in the hierarchy.
+    size_t m_leafCount = 0;
+};
+
+/// \class BVH
+///
+/// A binary bounding volume hierarchy, which is itself a scene object composed of a collection of
+/// child scene objects.
+///
+/// By default, the hierarchy is built top-down, where each interior node is split according to the
+/// <em>surface area heuristic</em> (SAH).  The probability of a ray hitting a child node is estimated by
+/// the ratio of its surface area against the parent's, thus the split which minimizes the expected cost of
+/// intersecting child objects is chosen.  Candidate splits are evaluated over a fixed number of buckets
+/// along each axis.  Alternatively, see \ref BVHBuildMethod::LBVH.
+///
+/// Either build splits the top levels of the hierarchy serially, then builds the remaining subtrees in
+/// parallel.
+///
+/// Rays traverse the hierarchy by testing against each node's bounding box, visiting the nearer child first,
+/// and pruning nodes beyond the nearest hit found thus far.
+///
+/// The materials of the scene objects are compiled into a \ref MaterialTable owned by the hierarchy.
+class BVH : public SceneObject
+{
+public:
+    /// \class Node
+    ///
+    /// A node in the hierarchy.  Nodes are stored in depth-first order, such that the first child
+    /// of an interior node immediately follows its parent.
+    class Node
+    {
+    public:
+        /// The bounding box enclosing all scene objects under this node.
+        gm::Vec3fRange m_bounds;
+
+        /// For a leaf node, the index of the first scene object.
+        /// For an interior node, the index of the second child node.
+        int m_index = 0;
+
+        /// The number of scene objects in a leaf node.  Zero for interior nodes.
+        int m_objectCount = 0;
+
+        /// The axis which the child nodes were split along.
+        int m_splitAxis = 0;
+    };
+
+    /// Build a BVH over the scene objects \p i_sceneObjects.
+    ///
+    /// \param i_sceneObjects The scene objects to take ownership of.
+    /// \param i_settings The build method & parameters.
+    explicit BVH( SceneObjectPtrs&& i_sceneObjects, const BVHBuildSettings& i_settings = BVHBuildSettings() );
+
+    /// Not copyable or movable, because the compiled scene objects address the material table held by value.
+    BVH( const BVH& )            = delete;
+    BVH( BVH&& )                 = delete;
+    BVH& operator=( const BVH& ) = delete;
+    BVH& operator=( BVH&& )      = delete;
+
+    virtual inline bool
+    Hit( const Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        if ( m_nodes.empty() )
+        {
+            return false;
+        }
+
+        bool  objectHit           = false;
+        float nearestHitMagnitude = i_magnitudeRange.Max();
+
+        // Stack of nodes pending a visit.
+        int nodeStack[ c_maxDepth ];
+        int stackSize = 0;
+        int nodeIndex = 0;
+        while ( true )
+        {
+            const Node&    node = m_nodes[ nodeIndex ];
+            gm::FloatRange nodeIntersections;
+            if ( gm::RayAABBIntersection( i_ray.Origin(), i_ray.Direction(), node.m_bounds, nodeIntersections ) &&
+                 nodeIntersections.Min() < nearestHitMagnitude && nodeIntersections.Max() > i_magnitudeRange.Min() )
+            {
+                if ( node.m_objectCount > 0 )
+                {
+                    // Leaf node: test the ray against each scene object, narrowing the accepted range.
+                    for ( int objectIndex = node.m_index; objectIndex < node.m_index + node.m_objectCount;
+                          ++objectIndex )
+                    {
+                        if ( m_sceneObjects[ objectIndex ]->Hit(
+                                 i_ray, gm::FloatRange( i_magnitudeRange.Min(), nearestHitMagnitude ), o_record ) )
+                        {
+                            objectHit           = true;
+                            nearestHitMagnitude = o_record.m_magnitude;
+                        }
+                    }
+                }
+                else
+                {
+                    // Interior node: visit the nearer child first, deferring the farther child.
+                    if ( i_ray.Direction()[ node.m_splitAxis ] < 0.0f )
+                    {
+                        nodeStack[ stackSize++ ] = nodeIndex + 1;
+                        nodeIndex                = node.m_index;
+                    }
+                    else
+                    {
+                        nodeStack[ stackSize++ ] = node.m_index;
+                        nodeIndex                = nodeIndex + 1;
+                    }
+                    continue;
+                }
+            }
+
+            if ( stackSize == 0 )
+            {
+                break;
+            }
+            nodeIndex = nodeStack[ --stackSize ];
+        }
+
+        return objectHit;
+    }
+
+    virtual inline gm::Vec3fRange BoundingBox() const override
+    {
+        return m_nodes.empty() ? gm::Vec3fRange() : m_nodes[ 0 ].m_bounds;
+    }
+
+    virtual inline void CompileMaterials( MaterialTable& io_materials ) override
+    {
+        for ( const SceneObjectPtr& sceneObject : m_sceneObjects )
+        {
+            sceneObject->CompileMaterials( io_materials );
+        }
+        m_compiledMaterialTable = &io_materials;
+    }
+
+    virtual inline const MaterialTable* Materials() const override
+    {
+        return m_compiledMaterialTable;
+    }
+
+    /// Get the nodes of the hierarchy, in depth-first order.  The first node is the root.
+    ///
+    /// \return The hierarchy nodes.
+    inline const std::vector< Node >& Nodes() const
+    {
+        return m_nodes;
+    }
+
+    /// Get the scene objects, ordered such that each leaf node references a contiguous range.
+    ///
+    /// \return The scene objects.
+    inline const SceneObjectPtrs& SceneObjects() const
+    {
+        return m_sceneObjects;
+    }
+
+    /// Get the build time & quality of the hierarchy.
+    ///
+    /// \return The build statistics.
+    inline const BVHBuildStatistics& BuildStatistics() const
+    {
+        return m_buildStatistics;
+    }
+
+    /// Release ownership of the scene objects, leaving an empty hierarchy.
+    ///
+    /// \return The scene objects, in the order of \ref SceneObjects.
+    inline SceneObjectPtrs ReleaseSceneObjects()
+    {
+        m_nodes.clear();
+        return std::move( m_sceneObjects );
+    }
+
+    /// Compute the surface area of the bounding box \p i_bounds.
+    ///
+    /// \return The surface area, or zero if the bounding box is empty.
+    static inline float SurfaceArea( const gm::Vec3fRange& i_bounds )
+    {
+        if ( i_bounds.IsEmpty() )
+        {
+            return 0.0f;
+        }
+
+        gm::Vec3f diagonal = i_bounds.Max() - i_bounds.Min();
+        return 2.0f * ( diagonal[ 0 ] * diagonal[ 1 ] + diagonal[ 1 ] * diagonal[ 2 ] + diagonal[ 2 ] * diagonal[ 0 ] );
+    }
+
+    /// \var c_maxDepth
+    ///
+    /// The maximum depth of the hierarchy, which bounds the traversal stack size.
+    static constexpr int c_maxDepth = 64;
+
+private:
+    std::vector< Node >  m_nodes;
+    SceneObjectPtrs      m_sceneObjects;
+    BVHBuildStatistics   m_buildStatistics;
+    MaterialTable        m_materials;
+    const MaterialTable* m_compiledMaterialTable = nullptr;
+};
+
+RAYTRACE_NS_CLOSE
@@ -7,6 +7,7 @@
 #include <raytrace/raytrace.h>
 
 #include <gm/functions/crossProduct.h>
+#include <gm/functions/normalize.h>
 #include <gm/functions/radians.h>
 
 #include <gm/types/vec3f.h>
@@ -57,6 +58,14 @@ public:
         m_back  = gm::Normalize( m_origin - i_lookAt );
         m_right = gm::Normalize( gm::CrossProduct( i_viewUp, m_back ) );
         m_up    = gm::CrossProduct( m_back, m_right );
+
+        // Cache the viewport plane vectors, which are queried per camera ray.
+        m_viewportHorizontal = m_focalDistance * m_viewportWidth * m_right;
+        m_viewportVertical   = m_focalDistance * m_viewportHeight * m_up;
+        m_viewportBottomLeft = m_origin                          // From the camera origin...
+                               - ( m_viewportHorizontal * 0.5f ) // Horizontal translate of half the viewport plane.
+                               - ( m_viewportVertical * 0.5f )   // Vertical translate of half the viewport plane.
+                               - m_focalDistance * m_back;       // Translate forwards focal length units.
     }
 
     //-------------------------------------------------------------------------
@@ -66,28 +75,25 @@ public:
     /// Get the 3D vector matching the virtual viewport width.
     ///
     /// \return Vertical vector of the viewport width.
-    inline gm::Vec3f ViewportHorizontal() const
+    inline const gm::Vec3f& ViewportHorizontal() const
     {
-        return m_focalDistance * m_viewportWidth * m_right;
+        return m_viewportHorizontal;
     }
 
     /// Get the 3D vector matching the virtual viewport height.
     ///
     /// \return Vertical vector of the viewport height.
-    inline gm::Vec3f ViewportVertical() const
+    inline const gm::Vec3f& ViewportVertical() const
     {
-        return m_focalDistance * m_viewportHeight * m_up;
+        return m_viewportVertical;
     }
 
     /// Get the 3D coordinate of the bottom left corner of the viewport plane.
     ///
     /// \return The bottom left coordinate of the viewport plane.
-    inline gm::Vec3f ViewportBottomLeft() const
+    inline const gm::Vec3f& ViewportBottomLeft() const
     {
-        return m_origin                          // From the camera origin...
-               - ( ViewportHorizontal() * 0.5f ) // Horizontal translate of half the viewport plane.
-               - ( ViewportVertical() * 0.5f )   // Vertical translate of half the viewport plane.
-               - m_focalDistance * m_back;       // Translate forwards focal length units.
+        return m_viewportBottomLeft;
     }
 
     //-------------------------------------------------------------------------
@@ -157,6 +163,11 @@ private:
 
     // The origin of the camera.
     gm::Vec3f m_origin;
+
+    // Viewport plane vectors, derived from the members above.
+    gm::Vec3f m_viewportHorizontal;
+    gm::Vec3f m_viewportVertical;
+    gm::Vec3f m_viewportBottomLeft;
 };
 
 RAYTRACE_NS_CLOSE
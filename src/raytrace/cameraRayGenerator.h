@@ -0,0 +1,259 @@
+#pragma once
+
+/// \file raytrace/cameraRayGenerator.h
+///
+/// Generation of camera rays through the pixels of an image.
+
+#include <raytrace/camera.h>
+#include <raytrace/randomNumberGenerator.h>
+#include <raytrace/sampleMapping.h>
+#include <raytrace/ray.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/functions/normalize.h>
+
+#include <gm/types/vec2f.h>
+#include <gm/types/vec2i.h>
+#include <gm/types/vec3f.h>
+
+#include <cassert>
+#include <cstddef>
+
+RAYTRACE_NS_OPEN
+
+/// \class PinholeLens
+///
+/// Lens model of a pinhole camera, of zero aperture.  Every camera ray originates from the camera origin, thus the
+/// lens is not sampled at all, and the whole scene is in focus.
+class PinholeLens final
+{
+public:
+    /// Draw the uniform sample of the lens.  Nothing is drawn from \p io_rng.
+    static inline gm::Vec2f DrawSample( RandomNumberGenerator& )
+    {
+        return gm::Vec2f( 0.0f, 0.0f );
+    }
+
+    /// Map a uniform sample onto the lens, which is a single point.
+    static inline gm::Vec2f MapSample( const gm::Vec2f& )
+    {
+        return gm::Vec2f( 0.0f, 0.0f );
+    }
+
+    /// Map the \p i_count uniform samples \p io_samples onto the lens, in place.  They are ignored, thus left as is.
+    static inline void MapSamples( gm::Vec2f*, size_t )
+    {
+    }
+
+    /// Look up the lens sample at \p i_index of \p i_lensSamples, which may be null since it is ignored.
+    static inline gm::Vec2f LensSample( const gm::Vec2f*, size_t )
+    {
+        return gm::Vec2f( 0.0f, 0.0f );
+    }
+
+    /// Compute the camera ray towards \p i_focalPoint, on the focal plane.
+    static inline Ray GenerateRay( const gm::Vec3f& i_origin,
+                                   const gm::Vec3f&,
+                                   const gm::Vec3f&,
+                                   float,
+                                   const gm::Vec2f&,
+                                   const gm::Vec3f& i_focalPoint )
+    {
+        return Ray( i_origin, gm::Normalize( i_focalPoint - i_origin ) );
+    }
+};
+
+/// \class ThinLens
+///
+/// Lens model of a thin lens, of non-zero aperture.  Camera rays originate from a sampled point on the lens, such
+/// that objects away from the focal plane are blurred (depth of field).
+class ThinLens final
+{
+public:
+    /// Draw the uniform sample of the lens from \p io_rng, in the same order as \ref RandomPointInUnitDisk.
+    static inline gm::Vec2f DrawSample( RandomNumberGenerator& io_rng )
+    {
+        const float xSample = io_rng.NextFloat();
+        const float ySample = io_rng.NextFloat();
+        return gm::Vec2f( xSample, ySample );
+    }
+
+    /// Map the uniform sample \p i_sample onto a point in the unit disk.
+    static inline gm::Vec2f MapSample( const gm::Vec2f& i_sample )
+    {
+        return ConcentricDiskSample( i_sample );
+    }
+
+    /// Map the \p i_count uniform samples \p io_samples onto points in the unit disk, in place, with the batch
+    /// kernel.  The points are identical to those of \ref MapSample.
+    static inline void MapSamples( gm::Vec2f* io_samples, size_t i_count )
+    {
+        ConcentricDiskSamples( io_samples, i_count, io_samples );
+    }
+
+    /// Look up the lens sample at \p i_index of \p i_lensSamples, which must not be null.
+    static inline gm::Vec2f LensSample( const gm::Vec2f* i_lensSamples, size_t i_index )
+    {
+        assert( i_lensSamples != nullptr && "A thin lens cannot generate rays without lens samples." );
+        return i_lensSamples[ i_index ];
+    }
+
+    /// Compute the camera ray from the lens point \p i_lensSample, scaled by \p i_lensRadius, towards
+    /// \p i_focalPoint, on the focal plane.
+    static inline Ray GenerateRay( const gm::Vec3f& i_origin,
+                                   const gm::Vec3f& i_right,
+                                   const gm::Vec3f& i_up,
+                                   float            i_lensRadius,
+                                   const gm::Vec2f& i_lensSample,
+                                   const gm::Vec3f& i_focalPoint )
+    {
+        const gm::Vec3f lensOffset =
+            ( i_lensRadius * i_lensSample.X() ) * i_right + ( i_lensRadius * i_lensSample.Y() ) * i_up;
+
+        // Since the origin is offset by the lens, the inverse offset is applied to the direction such that the ray
+        // position _at the focal plane_ is the same regardless of the lens sample.
+        return Ray( i_origin + lensOffset, gm::Normalize( i_focalPoint - i_origin - lensOffset ) );
+    }
+};
+
+/// \class CameraRayGenerator
+///
+/// Generates the camera rays of a frame, from the constants of the camera & image resolution which are computed
+/// once per frame, rather than once per sample.
+///
+/// The lens model \p LensT (\ref PinholeLens or \ref ThinLens) is resolved at compile time, such that pinhole
+/// cameras do not pay for lens sampling.  \ref DispatchLensModel selects the model of a camera.
+///
+/// The sample offsets within the pixel and the lens samples can be drawn by the caller, such that ray generation is
+/// a pure function of its inputs.
+template < typename LensT >
+class CameraRayGenerator final
+{
+public:
+    /// Compute the per-frame constants of \p i_camera, rendering an image of \p i_imageSize.
+    ///
+    /// \param i_camera The camera.
+    /// \param i_imageSize The width & height of the image.
+    inline explicit CameraRayGenerator( const Camera& i_camera, const gm::Vec2i& i_imageSize )
+        : m_origin( i_camera.Origin() )
+        , m_right( i_camera.Right() )
+        , m_up( i_camera.Up() )
+        , m_viewportBottomLeft( i_camera.ViewportBottomLeft() )
+        , m_viewportHorizontal( i_camera.ViewportHorizontal() )
+        , m_viewportVertical( i_camera.ViewportVertical() )
+        , m_imageSize( float( i_imageSize.X() ), float( i_imageSize.Y() ) )
+        , m_lensRadius( i_camera.Aperture() * 0.5f )
+    {
+    }
+
+    /// Generate a camera ray through a position within the pixel \p i_pixelCoord, and a position on the lens.
+    ///
+    /// \param i_pixelCoord The pixel coordinate.
+    /// \param i_sampleOffset The offset of the position within the pixel, in [0,1) along each axis.
+    /// \param i_lensSample A point in the unit disk, which is scaled to the lens.  Ignored by \ref PinholeLens.
+    ///
+    /// \return The camera ray, with normalized direction.
+    inline Ray GenerateRay( const gm::Vec2i& i_pixelCoord,
+                            const gm::Vec2f& i_sampleOffset,
+                            const gm::Vec2f& i_lensSample ) const
+    {
+        // Compute normalised viewport coordinates (values between 0 and 1).
+        const float u = ( float( i_pixelCoord.X() ) + i_sampleOffset.X() ) / m_imageSize.X();
+        const float v = ( float( i_pixelCoord.Y() ) + i_sampleOffset.Y() ) / m_imageSize.Y();
+
+        const gm::Vec3f focalPoint = m_viewportBottomLeft + ( u * m_viewportHorizontal ) + ( v * m_viewportVertical );
+        return LensT::GenerateRay( m_origin, m_right, m_up, m_lensRadius, i_lensSample, focalPoint );
+    }
+
+    /// Draw the offset within the pixel, then the uniform lens sample, of a camera ray from \p io_rng.
+    ///
+    /// \param io_rng The random number generator of the pixel sample.
+    /// \param o_sampleOffset The offset of the position within the pixel, in [0,1) along each axis.
+    /// \param o_lensSample The uniform lens sample, in [0,1) along each axis, which is yet to be mapped onto the lens
+    /// with \ref MapLensSamples.  Always zero for \ref PinholeLens.
+    static inline void DrawSamples( RandomNumberGenerator& io_rng, gm::Vec2f& o_sampleOffset, gm::Vec2f& o_lensSample )
+    {
+        const float xOffset = io_rng.NextFloat();
+        const float yOffset = io_rng.NextFloat();
+        o_sampleOffset      = gm::Vec2f( xOffset, yOffset );
+        o_lensSample        = LensT::DrawSample( io_rng );
+    }
+
+    /// Map the \p i_count uniform lens samples \p io_lensSamples, drawn by \ref DrawSamples, onto the lens in place.
+    /// Points in the unit disk are mapped as a batch, using the widest kernel supported by the executing CPU.
+    static inline void MapLensSamples( gm::Vec2f* io_lensSamples, size_t i_count )
+    {
+        LensT::MapSamples( io_lensSamples, i_count );
+    }
+
+    /// Generate a camera ray through a jittered position within the pixel \p i_pixelCoord, drawing its samples
+    /// from \p io_rng with \ref DrawSamples.
+    ///
+    /// \param i_pixelCoord The pixel coordinate.
+    /// \param io_rng The random number generator of the pixel sample.
+    ///
+    /// \return The camera ray, with normalized direction.
+    inline Ray GenerateRay( const gm::Vec2i& i_pixelCoord, RandomNumberGenerator& io_rng ) const
+    {
+        gm::Vec2f sampleOffset;
+        gm::Vec2f lensSample;
+        DrawSamples( io_rng, sampleOffset, lensSample );
+        return GenerateRay( i_pixelCoord, sampleOffset, LensT::MapSample( lensSample ) );
+    }
+
+    /// Generate a batch of \p i_count camera rays, whose samples were drawn up front.
+    ///
+    /// Each ray is identical to that of \ref GenerateRay with the same inputs.
+    ///
+    /// \param i_pixelCoords The pixel coordinate of each ray.
+    /// \param i_sampleOffsets The offset within the pixel of each ray.
+    /// \param i_lensSamples The point in the unit disk of each ray, as mapped by \ref MapLensSamples.  May be null for
+    /// \ref PinholeLens, which ignores them, but not for \ref ThinLens.
+    /// \param i_count The number of rays.
+    /// \param o_rays The output camera rays.
+    inline void GenerateRays( const gm::Vec2i* i_pixelCoords,
+                              const gm::Vec2f* i_sampleOffsets,
+                              const gm::Vec2f* i_lensSamples,
+                              size_t           i_count,
+                              Ray*             o_rays ) const
+    {
+        for ( size_t rayIndex = 0; rayIndex < i_count; ++rayIndex )
+        {
+            o_rays[ rayIndex ] = GenerateRay( i_pixelCoords[ rayIndex ],
+                                              i_sampleOffsets[ rayIndex ],
+                                              LensT::LensSample( i_lensSamples, rayIndex ) );
+        }
+    }
+
+private:
+    gm::Vec3f m_origin;
+    gm::Vec3f m_right;
+    gm::Vec3f m_up;
+    gm::Vec3f m_viewportBottomLeft;
+    gm::Vec3f m_viewportHorizontal;
+    gm::Vec3f m_viewportVertical;
+    gm::Vec2f m_imageSize;
+    float     m_lensRadius = 0.0f;
+};
+
+/// Invoke \p i_function with the \ref CameraRayGenerator of the lens model of \p i_camera: \ref PinholeLens if its
+/// aperture is zero, otherwise \ref ThinLens.
+///
+/// \param i_camera The camera.
+/// \param i_imageSize The width & height of the image.
+/// \param i_function Function of the signature <tt>ResultT( const CameraRayGenerator< LensT >& )</tt>, for both
+/// lens models.
+///
+/// \return The result of \p i_function.
+template < typename FunctionT >
+inline auto DispatchLensModel( const Camera& i_camera, const gm::Vec2i& i_imageSize, FunctionT&& i_function )
+{
+    if ( i_camera.Aperture() > 0.0f )
+    {
+        return i_function( CameraRayGenerator< ThinLens >( i_camera, i_imageSize ) );
+    }
+
+    return i_function( CameraRayGenerator< PinholeLens >( i_camera, i_imageSize ) );
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,262 @@
+/// \file raytrace/checkpoint.cpp
+
+#include <raytrace/checkpoint.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define RAYTRACE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RAYTRACE_NS_OPEN
+
+/// \var c_checkpointMagic
+///
+/// The leading bytes of a checkpoint file.
+static const char c_checkpointMagic[ 8 ] = {'R', 'T', 'C', 'K', 'P', 'T', '\0', '\0'};
+
+/// \var c_checkpointVersion
+///
+/// Version of the checkpoint file layout.
+static constexpr uint32_t c_checkpointVersion = 2;
+
+/// \var c_byteOrderMark
+///
+/// Value of \ref CheckpointHeader::m_byteOrderMark, as written by the host.
+static constexpr uint32_t c_byteOrderMark = 0x01020304;
+
+/// Fill the fields of a checkpoint header, for a render with \p i_settings.
+static CheckpointHeader
+MakeCheckpointHeader( const RenderSettings& i_settings, int i_width, int i_height, int i_passCount )
+{
+    // Zero the padding too, such that the file contents are deterministic.
+    CheckpointHeader header;
+    memset( &header, 0, sizeof( header ) );
+
+    memcpy( header.m_magic, c_checkpointMagic, sizeof( header.m_magic ) );
+    header.m_version         = c_checkpointVersion;
+    header.m_byteOrderMark   = c_byteOrderMark;
+    header.m_pixelRecordSize = sizeof( SampleStatistics );
+    header.m_width           = i_width;
+    header.m_height          = i_height;
+    header.m_passCount       = i_passCount;
+    header.m_pixelDataOffset = c_checkpointPixelDataAlignment;
+
+    header.m_shadingMode                = static_cast< int32_t >( i_settings.m_shadingMode );
+    header.m_sampler                    = static_cast< int32_t >( i_settings.m_sampler );
+    header.m_minSamplesPerPixel         = i_settings.m_sampling.m_minSamplesPerPixel;
+    header.m_maxSamplesPerPixel         = i_settings.m_sampling.m_maxSamplesPerPixel;
+    header.m_errorThreshold             = i_settings.m_sampling.m_errorThreshold;
+    header.m_rayBounceLimit             = i_settings.m_pathTracer.m_rayBounceLimit;
+    header.m_russianRouletteStartBounce = i_settings.m_pathTracer.m_russianRouletteStartBounce;
+    header.m_minSurvivalProbability     = i_settings.m_pathTracer.m_survivalProbabilityRange.Min();
+    header.m_maxSurvivalProbability     = i_settings.m_pathTracer.m_survivalProbabilityRange.Max();
+    header.m_seed                       = i_settings.m_seed;
+    return header;
+}
+
+/// Check that the checkpoint header \p i_header was written by a render with the same settings as \p i_expected,
+/// printing every mismatch.
+static bool CheckpointSettingsMatch( const CheckpointHeader& i_header, const CheckpointHeader& i_expected )
+{
+    struct Field
+    {
+        const char* m_name;
+        const char* m_option; // The command line option setting the field, if any.
+        bool        m_match;
+    };
+
+    // The maximum sample count is listed first, since in fixed-rate mode the minimum follows it.
+    const Field fields[] = {
+        {"shading mode", nullptr, i_header.m_shadingMode == i_expected.m_shadingMode},
+        {"sampler", "--sampler", i_header.m_sampler == i_expected.m_sampler},
+        {"maximum samples per-pixel",
+         "--samplesPerPixel",
+         i_header.m_maxSamplesPerPixel == i_expected.m_maxSamplesPerPixel},
+        {"minimum samples per-pixel",
+         "--minSamplesPerPixel",
+         i_header.m_minSamplesPerPixel == i_expected.m_minSamplesPerPixel},
+        {"error threshold", "--errorThreshold", i_header.m_errorThreshold == i_expected.m_errorThreshold},
+        {"ray bounce limit", "--rayBounceLimit", i_header.m_rayBounceLimit == i_expected.m_rayBounceLimit},
+        {"Russian roulette",
+         "--russianRoulette",
+         i_header.m_russianRouletteStartBounce == i_expected.m_russianRouletteStartBounce},
+        {"minimum survival probability",
+         "--minSurvivalProbability",
+         i_header.m_minSurvivalProbability == i_expected.m_minSurvivalProbability},
+        {"maximum survival probability",
+         "--maxSurvivalProbability",
+         i_header.m_maxSurvivalProbability == i_expected.m_maxSurvivalProbability},
+        {"seed", "--seed", i_header.m_seed == i_expected.m_seed},
+    };
+
+    bool match = true;
+    for ( const Field& field : fields )
+    {
+        if ( field.m_match )
+        {
+            continue;
+        }
+
+        if ( field.m_option != nullptr )
+        {
+            fprintf( stderr, "The checkpoint was written with a different %s (%s)!\n", field.m_name, field.m_option );
+        }
+        else
+        {
+            fprintf( stderr, "The checkpoint was written with a different %s!\n", field.m_name );
+        }
+        match = false;
+    }
+
+    return match;
+}
+
+bool WriteCheckpoint( const std::string&                     i_filePath,
+                      const RenderSettings&                  i_settings,
+                      const ImageBuffer< SampleStatistics >& i_accumulation,
+                      int                                    i_passCount )
+{
+    const CheckpointHeader header =
+        MakeCheckpointHeader( i_settings, i_accumulation.Width(), i_accumulation.Height(), i_passCount );
+
+    const std::string temporaryPath = i_filePath + ".tmp";
+    FILE*             file          = fopen( temporaryPath.c_str(), "wb" );
+    if ( file == nullptr )
+    {
+        fprintf( stderr, "Cannot open file '%s' for writing!\n", temporaryPath.c_str() );
+        return false;
+    }
+
+    // The header is padded up to the aligned offset of the pixel records.
+    std::vector< char > headerBytes( header.m_pixelDataOffset, 0 );
+    memcpy( headerBytes.data(), &header, sizeof( header ) );
+
+    const size_t pixelCount = static_cast< size_t >( i_accumulation.Width() ) * i_accumulation.Height();
+    bool         success    = fwrite( headerBytes.data(), 1, headerBytes.size(), file ) == headerBytes.size();
+    success = success && fwrite( i_accumulation.Data(), sizeof( SampleStatistics ), pixelCount, file ) == pixelCount;
+    success = ( fclose( file ) == 0 ) && success;
+    success = success && std::rename( temporaryPath.c_str(), i_filePath.c_str() ) == 0;
+    if ( !success )
+    {
+        fprintf( stderr, "Failed to write file '%s'!\n", i_filePath.c_str() );
+    }
+
+    return success;
+}
+
+/// Validate the checkpoint \p i_bytes of \p i_size bytes, and copy its pixel records into \p o_accumulation.
+static bool ReadCheckpointBytes( const char*                      i_bytes,
+                                 size_t                           i_size,
+                                 const RenderSettings&            i_settings,
+                                 ImageBuffer< SampleStatistics >& o_accumulation,
+                                 int&                             o_passCount )
+{
+    CheckpointHeader header;
+    if ( i_size < sizeof( header ) )
+    {
+        fprintf( stderr, "The checkpoint is truncated!\n" );
+        return false;
+    }
+
+    memcpy( &header, i_bytes, sizeof( header ) );
+    if ( memcmp( header.m_magic, c_checkpointMagic, sizeof( header.m_magic ) ) != 0 ||
+         header.m_version != c_checkpointVersion )
+    {
+        fprintf( stderr, "The file is not a checkpoint of this version!\n" );
+        return false;
+    }
+
+    if ( header.m_byteOrderMark != c_byteOrderMark || header.m_pixelRecordSize != sizeof( SampleStatistics ) )
+    {
+        fprintf( stderr, "The checkpoint was written by an incompatible host!\n" );
+        return false;
+    }
+
+    const CheckpointHeader expected =
+        MakeCheckpointHeader( i_settings, header.m_width, header.m_height, header.m_passCount );
+    if ( !CheckpointSettingsMatch( header, expected ) )
+    {
+        return false;
+    }
+
+    const size_t pixelCount = static_cast< size_t >( header.m_width ) * header.m_height;
+    if ( header.m_width < 0 || header.m_height < 0 || header.m_pixelDataOffset > i_size ||
+         ( i_size - header.m_pixelDataOffset ) / sizeof( SampleStatistics ) < pixelCount )
+    {
+        fprintf( stderr, "The checkpoint is truncated!\n" );
+        return false;
+    }
+
+    o_accumulation.Resize( header.m_width, header.m_height );
+    memcpy( o_accumulation.Data(), i_bytes + header.m_pixelDataOffset, pixelCount * sizeof( SampleStatistics ) );
+    o_passCount = header.m_passCount;
+    return true;
+}
+
+bool ReadCheckpoint( const std::string&               i_filePath,
+                     const RenderSettings&            i_settings,
+                     ImageBuffer< SampleStatistics >& o_accumulation,
+                     int&                             o_passCount )
+{
+#if defined( RAYTRACE_MMAP )
+    // The pixel records are copied straight out of the mapped file.
+    const int fileDescriptor = open( i_filePath.c_str(), O_RDONLY );
+    if ( fileDescriptor < 0 )
+    {
+        fprintf( stderr, "Cannot open file '%s' for reading!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    struct stat fileStatus;
+    void*       mapping = MAP_FAILED;
+    if ( fstat( fileDescriptor, &fileStatus ) == 0 && fileStatus.st_size > 0 )
+    {
+        mapping = mmap( nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0 );
+    }
+    close( fileDescriptor );
+
+    if ( mapping == MAP_FAILED )
+    {
+        fprintf( stderr, "Cannot map file '%s' into memory!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    const bool success = ReadCheckpointBytes(
+        static_cast< const char* >( mapping ), fileStatus.st_size, i_settings, o_accumulation, o_passCount );
+    munmap( mapping, fileStatus.st_size );
+#else
+    FILE* file = fopen( i_filePath.c_str(), "rb" );
+    if ( file == nullptr )
+    {
+        fprintf( stderr, "Cannot open file '%s' for reading!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    std::vector< char > bytes;
+    char                buffer[ 1 << 16 ];
+    size_t              readSize;
+    while ( ( readSize = fread( buffer, 1, sizeof( buffer ), file ) ) > 0 )
+    {
+        bytes.insert( bytes.end(), buffer, buffer + readSize );
+    }
+    fclose( file );
+
+    const bool success = ReadCheckpointBytes( bytes.data(), bytes.size(), i_settings, o_accumulation, o_passCount );
+#endif
+
+    if ( !success )
+    {
+        fprintf( stderr, "Failed to read checkpoint '%s'!\n", i_filePath.c_str() );
+    }
+
+    return success;
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,109 @@
+#pragma once
+
+/// \file raytrace/checkpoint.h
+///
+/// Binary checkpoints of the samples accumulated by a render, from which an interrupted render can resume.
+
+#include <raytrace/adaptiveSampling.h>
+#include <raytrace/imageBuffer.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/renderSettings.h>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+RAYTRACE_NS_OPEN
+
+static_assert( std::is_trivially_copyable< SampleStatistics >::value,
+               "SampleStatistics is expected to be trivially copyable, to be stored in checkpoints as is." );
+
+/// \var c_checkpointPixelDataAlignment
+///
+/// Alignment of the pixel records within a checkpoint file, such that they can be mapped into memory in place.
+constexpr uint64_t c_checkpointPixelDataAlignment = 4096;
+
+/// \class CheckpointHeader
+///
+/// The header at the start of a checkpoint file.
+///
+/// The header is followed, at \ref m_pixelDataOffset, by one \ref SampleStatistics record per pixel, in the
+/// order of the pixels of \ref ImageBuffer.  The records are stored in the layout & byte order of the host, thus the
+/// file is read by mapping it into memory, without parsing.
+///
+/// The random numbers of each sample are keyed by the pixel, the sample index, and \ref m_seed.  Thus the position
+/// of each pixel within its random number streams is the sample count held by its record.
+class CheckpointHeader
+{
+public:
+    /// Identifies the file as a checkpoint.
+    char m_magic[ 8 ];
+
+    /// Version of the file layout.
+    uint32_t m_version;
+
+    /// A known value, to detect files written by a host of different byte order.
+    uint32_t m_byteOrderMark;
+
+    /// Size of each pixel record, to detect files written with a different record layout.
+    uint32_t m_pixelRecordSize;
+
+    /// Dimensions of the image.
+    int32_t m_width;
+    int32_t m_height;
+
+    /// Number of complete sample passes, which the render resumes from.
+    int32_t m_passCount;
+
+    /// Offset of the pixel records from the start of the file.
+    uint64_t m_pixelDataOffset;
+
+    /// Settings which determine the samples, and thus must match those of the resuming render.
+    int32_t  m_shadingMode;
+    int32_t  m_sampler;
+    int32_t  m_minSamplesPerPixel;
+    int32_t  m_maxSamplesPerPixel;
+    float    m_errorThreshold;
+    int32_t  m_rayBounceLimit;
+    int32_t  m_russianRouletteStartBounce;
+    float    m_minSurvivalProbability;
+    float    m_maxSurvivalProbability;
+    uint32_t m_seed;
+};
+
+static_assert( std::is_trivially_copyable< CheckpointHeader >::value,
+               "CheckpointHeader is expected to be trivially copyable." );
+
+/// Write a checkpoint of the samples \p i_accumulation, accumulated over \p i_passCount passes of a render with
+/// \p i_settings, into file location \p i_filePath.
+///
+/// The checkpoint is written to a temporary file, then moved over \p i_filePath, such that an interruption while
+/// writing leaves the previous checkpoint intact.
+///
+/// \param i_filePath file location to save the checkpoint.
+/// \param i_settings the settings of the render.
+/// \param i_accumulation the samples accumulated per-pixel.
+/// \param i_passCount the number of complete sample passes.
+///
+/// \return success of writing the checkpoint.
+bool WriteCheckpoint( const std::string&                     i_filePath,
+                      const RenderSettings&                  i_settings,
+                      const ImageBuffer< SampleStatistics >& i_accumulation,
+                      int                                    i_passCount );
+
+/// Read the checkpoint at file location \p i_filePath, written by a render with the same settings as
+/// \p i_settings.
+///
+/// \param i_filePath file location of the checkpoint.
+/// \param i_settings the settings of the resuming render.
+/// \param o_accumulation the samples accumulated per-pixel.  Resized to the dimensions of the checkpoint.
+/// \param o_passCount the number of complete sample passes.
+///
+/// \return success of reading the checkpoint.  Fails if the file is not a checkpoint, or was written by a render
+/// with different settings.
+bool ReadCheckpoint( const std::string&               i_filePath,
+                     const RenderSettings&            i_settings,
+                     ImageBuffer< SampleStatistics >& o_accumulation,
+                     int&                             o_passCount );
+
+RAYTRACE_NS_CLOSE
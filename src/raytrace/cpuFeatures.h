@@ -0,0 +1,83 @@
+#pragma once
+
+/// \file raytrace/cpuFeatures.h
+///
+/// Run-time detection of CPU instruction set extensions, for selecting vectorized code paths.
+
+#include <raytrace/raytrace.h>
+
+/// \def RAYTRACE_X86
+///
+/// Defined when compiling for an x86 or x86-64 target, where SSE & AVX code paths are available.
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#define RAYTRACE_X86
+#endif
+
+/// \def RAYTRACE_TARGET_AVX2
+///
+/// Function attribute enabling AVX2 & FMA code generation for a single function, such that it can be
+/// compiled without enabling AVX2 for the entire translation unit.
+#if defined( RAYTRACE_X86 ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#define RAYTRACE_TARGET_AVX2 __attribute__( ( target( "avx2,fma" ) ) )
+#else
+#define RAYTRACE_TARGET_AVX2
+#endif
+
+#if defined( RAYTRACE_X86 ) && defined( _MSC_VER )
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+RAYTRACE_NS_OPEN
+
+/// \enum SIMDLevel
+///
+/// The vector instruction set levels which code paths are specialized for.
+enum class SIMDLevel
+{
+    Scalar = 0, ///< No vector instructions.
+    SSE2,       ///< 4-wide float vectors.
+    AVX2        ///< 8-wide float vectors, with fused multiply-add.
+};
+
+/// Detect the highest \ref SIMDLevel supported by the executing CPU and operating system.
+///
+/// The detection is performed once, and cached for subsequent calls.
+///
+/// \return The supported SIMD level.
+inline SIMDLevel DetectSIMDLevel()
+{
+    static const SIMDLevel s_simdLevel = []() {
+#if defined( RAYTRACE_X86 ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+        __builtin_cpu_init();
+        if ( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) )
+        {
+            return SIMDLevel::AVX2;
+        }
+        return __builtin_cpu_supports( "sse2" ) ? SIMDLevel::SSE2 : SIMDLevel::Scalar;
+#elif defined( RAYTRACE_X86 ) && defined( _MSC_VER )
+        int registers[ 4 ];
+        __cpuid( registers, 1 );
+        const bool sse2    = ( registers[ 3 ] & ( 1 << 26 ) ) != 0;
+        const bool fma     = ( registers[ 2 ] & ( 1 << 12 ) ) != 0;
+        const bool osxsave = ( registers[ 2 ] & ( 1 << 27 ) ) != 0;
+
+        // The operating system must preserve the YMM register state across context switches.
+        const bool ymmState = osxsave && ( _xgetbv( 0 ) & 0x6 ) == 0x6;
+
+        __cpuidex( registers, 7, 0 );
+        const bool avx2 = ( registers[ 1 ] & ( 1 << 5 ) ) != 0;
+        if ( avx2 && fma && ymmState )
+        {
+            return SIMDLevel::AVX2;
+        }
+        return sse2 ? SIMDLevel::SSE2 : SIMDLevel::Scalar;
+#else
+        return SIMDLevel::Scalar;
+#endif
+    }();
+
+    return s_simdLevel;
+}
+
+RAYTRACE_NS_CLOSE
@@ -9,6 +9,7 @@
 
 #include <gm/functions/clamp.h>
 #include <gm/functions/min.h>
+#include <gm/functions/normalize.h>
 
 #include <raytrace/hitRecord.h>
 #include <raytrace/material.h>
@@ -25,79 +26,110 @@ RAYTRACE_NS_OPEN
 /// The refractive index of air.
 constexpr float c_airRefractiveIndex = 1.0f;
 
+/// Scatter a ray off a dielectric surface, by either refraction or reflection.
+///
+/// This is the kernel behind \ref Dielectric::Scatter, exposed such that materials stored by value (see
+/// \ref MaterialRecord) can be scattered without virtual dispatch.
+///
+/// \param i_refractiveIndex The refractive index of the material.
+/// \param i_ray Incident ray.
+/// \param i_hitRecord The recorded hit information of the ray against the geometry.
+/// \param io_rng The random number generator to draw from.
+/// \param o_attenuation Color produced by the surface.
+/// \param o_scatteredRay The scattered ray.
+///
+/// \return Always true, as a dielectric surface scatters every incident ray.
+inline bool ScatterDielectric( float                  i_refractiveIndex,
+                               const Ray&             i_ray,
+                               const HitRecord&       i_hitRecord,
+                               RandomNumberGenerator& io_rng,
+                               gm::Vec3f&             o_attenuation,
+                               Ray&                   o_scatteredRay )
+{
+    // Fixed attenuation color
+    o_attenuation = gm::Vec3f( 1.0f, 1.0f, 1.0f );
+
+    // Check if the incident ray is traveling in from the outside towards the surface,
+    // or traveling within the surface towards the outside.
+    float     incidentIndex, refractedIndex;
+    gm::Vec3f incidentNormal;
+    if ( gm::DotProduct( i_ray.Direction(), i_hitRecord.m_normal ) < 0 )
+    {
+        // The incident ray and the normal are opposing, thus the incident ray is outside and
+        // heading into the geometric surface.
+        incidentIndex  = c_airRefractiveIndex;
+        refractedIndex = i_refractiveIndex;
+        incidentNormal = i_hitRecord.m_normal;
+    }
+    else
+    {
+        // The incident ray and the normal form an acute angle, thus the incident ray is within the geometric
+        // surface and heading outwards.
+        incidentIndex  = i_refractiveIndex;
+        refractedIndex = c_airRefractiveIndex;
+        incidentNormal = -i_hitRecord.m_normal;
+    }
+
+    gm::Vec3f normRayDir = gm::Normalize( i_ray.Direction() );
+
+    // Check for total internal reflection (when the ray is inside a material with
+    // higher frefractive index.
+    double cosTheta = gm::Min( gm::DotProduct( -normRayDir, incidentNormal ), 1.0f );
+    double sinTheta = sqrt( 1.0 - cosTheta * cosTheta );
+    if ( ( incidentIndex / refractedIndex ) * sinTheta > 1.0 )
+    {
+        gm::Vec3f reflectedDirection = Reflect( normRayDir, incidentNormal );
+        o_scatteredRay               = Ray( i_hitRecord.m_position, reflectedDirection );
+        return true;
+    }
+
+    // Schlick approximation for reflections produced when the ray is at a steep angle to
+    // to the geometric surface normal.
+    if ( io_rng.NextFloat() < Schlick( cosTheta, incidentIndex / refractedIndex ) )
+    {
+        gm::Vec3f reflectedDirection = Reflect( normRayDir, incidentNormal );
+        o_scatteredRay               = Ray( i_hitRecord.m_position, reflectedDirection );
+        return true;
+    }
+
+    // Compute new refracted direction.
+    gm::Vec3f refractedDirection = Refract( normRayDir, incidentNormal, incidentIndex, refractedIndex );
+
+    // Assemble ray.
+    o_scatteredRay = Ray( i_hitRecord.m_position, refractedDirection );
+
+    return true;
+}
+
 /// \class Dielectric
 ///
 /// The dielectric material refracts incoming rays.
 ///
 /// Properties:
 /// - "refractiveIndex" which describes the refractive index of the material.
-class Dielectric : public Material
+class Dielectric final : public Material
 {
 public:
     /// Explicit constructor with the refractive index of the material.
     inline explicit Dielectric( float i_refractiveIndex )
-        : m_refractiveIndex( i_refractiveIndex )
+        : Material( MaterialType::Dielectric )
+        , m_refractiveIndex( i_refractiveIndex )
     {
     }
 
-    inline virtual bool Scatter( const Ray&       i_ray,
-                                 const HitRecord& i_hitRecord,
-                                 gm::Vec3f&       o_attenuation,
-                                 Ray&             o_scatteredRay ) const override
+    /// Get the refractive index of the material.
+    inline float RefractiveIndex() const
     {
-        // Fixed attenuation color
-        o_attenuation = gm::Vec3f( 1.0f, 1.0f, 1.0f );
-
-        // Check if the incident ray is traveling in from the outside towards the surface,
-        // or traveling within the surface towards the outside.
-        float     incidentIndex, refractedIndex;
-        gm::Vec3f incidentNormal;
-        if ( gm::DotProduct( i_ray.Direction(), i_hitRecord.m_normal ) < 0 )
-        {
-            // The incident ray and the normal are opposing, thus the incident ray is outside and
-            // heading into the geometric surface.
-            incidentIndex  = c_airRefractiveIndex;
-            refractedIndex = m_refractiveIndex;
-            incidentNormal = i_hitRecord.m_normal;
-        }
-        else
-        {
-            // The incident ray and the normal form an acute angle, thus the incident ray is within the geometric
-            // surface and heading outwards.
-            incidentIndex  = m_refractiveIndex;
-            refractedIndex = c_airRefractiveIndex;
-            incidentNormal = -i_hitRecord.m_normal;
-        }
-
-        gm::Vec3f normRayDir = gm::Normalize( i_ray.Direction() );
-
-        // Check for total internal reflection (when the ray is inside a material with
-        // higher frefractive index.
-        double cosTheta = gm::Min( gm::DotProduct( -normRayDir, incidentNormal ), 1.0f );
-        double sinTheta = sqrt( 1.0 - cosTheta * cosTheta );
-        if ( ( incidentIndex / refractedIndex ) * sinTheta > 1.0 )
-        {
-            gm::Vec3f reflectedDirection = Reflect( normRayDir, incidentNormal );
-            o_scatteredRay               = Ray( i_hitRecord.m_position, reflectedDirection );
-            return true;
-        }
-
-        // Schlick approximation for reflections produced when the ray is at a steep angle to
-        // to the geometric surface normal.
-        if ( gm::RandomNumber( gm::FloatRange( 0.0f, 1.0f ) ) < Schlick( cosTheta, incidentIndex / refractedIndex ) )
-        {
-            gm::Vec3f reflectedDirection = Reflect( normRayDir, incidentNormal );
-            o_scatteredRay               = Ray( i_hitRecord.m_position, reflectedDirection );
-            return true;
-        }
-
-        // Compute new refracted direction.
-        gm::Vec3f refractedDirection = Refract( normRayDir, incidentNormal, incidentIndex, refractedIndex );
-
-        // Assemble ray.
-        o_scatteredRay = Ray( i_hitRecord.m_position, refractedDirection );
+        return m_refractiveIndex;
+    }
 
-        return true;
+    inline virtual bool Scatter( const Ray&             i_ray,
+                                 const HitRecord&       i_hitRecord,
+                                 RandomNumberGenerator& io_rng,
+                                 gm::Vec3f&             o_attenuation,
+                                 Ray&                   o_scatteredRay ) const override
+    {
+        return ScatterDielectric( m_refractiveIndex, i_ray, i_hitRecord, io_rng, o_attenuation, o_scatteredRay );
     }
 
 private:
@@ -0,0 +1,208 @@
+#pragma once
+
+/// \file raytrace/exrImageWriter.h
+///
+/// Serialization of a linear, floating-point image into an uncompressed OpenEXR file on disk.
+
+#include <raytrace/imageBuffer.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec3f.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class EXRFileBuffer
+///
+/// Assembles the bytes of an OpenEXR file in memory.  Multi-byte values are stored little-endian, as the format
+/// requires, regardless of the host byte order.
+class EXRFileBuffer final
+{
+public:
+    /// Append a null-terminated string.
+    inline void AppendString( const char* i_string )
+    {
+        m_bytes.insert( m_bytes.end(), i_string, i_string + strlen( i_string ) + 1 );
+    }
+
+    /// Append a single byte.
+    inline void AppendUInt8( uint8_t i_value )
+    {
+        m_bytes.push_back( i_value );
+    }
+
+    /// Append a 32-bit integer.
+    inline void AppendInt32( int32_t i_value )
+    {
+        _AppendLittleEndian( static_cast< uint32_t >( i_value ), 4 );
+    }
+
+    /// Append a 64-bit unsigned integer.
+    inline void AppendUInt64( uint64_t i_value )
+    {
+        _AppendLittleEndian( i_value, 8 );
+    }
+
+    /// Append a 32-bit float.
+    inline void AppendFloat( float i_value )
+    {
+        uint32_t bits;
+        memcpy( &bits, &i_value, sizeof( bits ) );
+        _AppendLittleEndian( bits, 4 );
+    }
+
+    /// Append the header of an attribute, whose value of \p i_size bytes should be appended next.
+    inline void AppendAttribute( const char* i_name, const char* i_type, int32_t i_size )
+    {
+        AppendString( i_name );
+        AppendString( i_type );
+        AppendInt32( i_size );
+    }
+
+    /// Get the number of bytes appended.
+    inline size_t Size() const
+    {
+        return m_bytes.size();
+    }
+
+    /// Reserve space for \p i_size bytes in total.
+    inline void Reserve( size_t i_size )
+    {
+        m_bytes.reserve( i_size );
+    }
+
+    /// Get the bytes appended.
+    inline const std::vector< uint8_t >& Bytes() const
+    {
+        return m_bytes;
+    }
+
+private:
+    inline void _AppendLittleEndian( uint64_t i_value, int i_byteCount )
+    {
+        for ( int byteIndex = 0; byteIndex < i_byteCount; ++byteIndex )
+        {
+            m_bytes.push_back( static_cast< uint8_t >( i_value >> ( 8 * byteIndex ) ) );
+        }
+    }
+
+    std::vector< uint8_t > m_bytes;
+};
+
+/// Write the image \p i_image into file location \p i_filePath, as a single-part, scanline OpenEXR image with
+/// 32-bit float "R", "G", "B" channels and no compression.
+///
+/// The channel values are written as is, without gamma correction, clamping, or quantization.  Each EXR scanline
+/// stores its channels one after another, so the pixels are transposed into the file bytes, which are then written
+/// with a single call.
+///
+/// \param i_image the image buffer to write.
+/// \param i_filePath file location to save the EXR image.
+///
+/// \return success of writing the image.
+inline bool WriteEXRImage( const RGBImageBuffer& i_image, const std::string& i_filePath )
+{
+    const int32_t width  = i_image.Width();
+    const int32_t height = i_image.Height();
+
+    // Channels are listed, and stored within each scanline, in alphabetical order.
+    const char*   channelNames[]    = {"B", "G", "R"};
+    const int     channelElements[] = {2, 1, 0};
+    const int32_t channelListSize   = 3 * ( 2 + 16 ) + 1;
+    const int32_t scanlineDataSize  = 3 * static_cast< int32_t >( sizeof( float ) ) * width;
+
+    EXRFileBuffer buffer;
+
+    // Magic number & version 2, with all flags cleared for a single-part scanline file.
+    buffer.AppendInt32( 20000630 );
+    buffer.AppendInt32( 2 );
+
+    // Header attributes, terminated by an empty name.
+    buffer.AppendAttribute( "channels", "chlist", channelListSize );
+    for ( const char* channelName : channelNames )
+    {
+        buffer.AppendString( channelName );
+        buffer.AppendInt32( 2 ); // FLOAT pixel type.
+        buffer.AppendUInt8( 0 ); // pLinear.
+        buffer.AppendUInt8( 0 ); // Reserved.
+        buffer.AppendUInt8( 0 );
+        buffer.AppendUInt8( 0 );
+        buffer.AppendInt32( 1 ); // x & y sampling.
+        buffer.AppendInt32( 1 );
+    }
+    buffer.AppendUInt8( 0 );
+
+    buffer.AppendAttribute( "compression", "compression", 1 );
+    buffer.AppendUInt8( 0 ); // NO_COMPRESSION.
+
+    for ( const char* windowName : {"dataWindow", "displayWindow"} )
+    {
+        buffer.AppendAttribute( windowName, "box2i", 16 );
+        buffer.AppendInt32( 0 );
+        buffer.AppendInt32( 0 );
+        buffer.AppendInt32( width - 1 );
+        buffer.AppendInt32( height - 1 );
+    }
+
+    buffer.AppendAttribute( "lineOrder", "lineOrder", 1 );
+    buffer.AppendUInt8( 0 ); // INCREASING_Y.
+
+    buffer.AppendAttribute( "pixelAspectRatio", "float", 4 );
+    buffer.AppendFloat( 1.0f );
+
+    buffer.AppendAttribute( "screenWindowCenter", "v2f", 8 );
+    buffer.AppendFloat( 0.0f );
+    buffer.AppendFloat( 0.0f );
+
+    buffer.AppendAttribute( "screenWindowWidth", "float", 4 );
+    buffer.AppendFloat( 1.0f );
+
+    buffer.AppendUInt8( 0 );
+
+    // Offset table of the scanline chunks, each of which holds its y-coordinate, data size, and pixel data.
+    const size_t chunkSize = 2 * sizeof( int32_t ) + scanlineDataSize;
+    const size_t dataBegin = buffer.Size() + height * sizeof( uint64_t );
+    buffer.Reserve( dataBegin + height * chunkSize );
+    for ( int32_t line = 0; line < height; ++line )
+    {
+        buffer.AppendUInt64( dataBegin + line * chunkSize );
+    }
+
+    // EXR scanlines are ordered top to bottom.
+    for ( int32_t line = 0; line < height; ++line )
+    {
+        const int yCoord = height - 1 - line;
+        buffer.AppendInt32( line );
+        buffer.AppendInt32( scanlineDataSize );
+        for ( int channelElement : channelElements )
+        {
+            for ( int xCoord = 0; xCoord < width; ++xCoord )
+            {
+                buffer.AppendFloat( i_image( xCoord, yCoord )[ channelElement ] );
+            }
+        }
+    }
+
+    FILE* file = fopen( i_filePath.c_str(), "wb" );
+    if ( file == nullptr )
+    {
+        fprintf( stderr, "Cannot open file '%s' for writing!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    bool success = fwrite( buffer.Bytes().data(), 1, buffer.Size(), file ) == buffer.Size();
+    success      = ( fclose( file ) == 0 ) && success;
+    if ( !success )
+    {
+        fprintf( stderr, "Failed to write file '%s'!\n", i_filePath.c_str() );
+    }
+
+    return success;
+}
+
+RAYTRACE_NS_CLOSE
@@ -9,8 +9,16 @@
 #include <raytrace/material.h>
 #include <raytrace/raytrace.h>
 
+#include <cstdint>
+#include <type_traits>
+
 RAYTRACE_NS_OPEN
 
+/// \var c_invalidMaterialIndex
+///
+/// The material index of a hit against an object whose materials have not been compiled into a table.
+constexpr uint32_t c_invalidMaterialIndex = UINT32_MAX;
+
 /// \class HitRecord
 ///
 /// HitRecord stores a record of a ray hitting a scene object, so that it may be used to influence
@@ -28,7 +36,15 @@ public:
     float m_magnitude;
 
     /// Material associated with the geometry that was hit by the ray.
-    MaterialSharedPtr m_material;
+    ///
+    /// This is a non-owning handle: the material is owned by the scene object which was hit, and remains valid
+    /// for its lifetime.  Keeping the record free of reference counting avoids atomic traffic on every hit.
+    const Material* m_material = nullptr;
+
+    /// Index of the same material, into the \ref MaterialTable of the scene (see \ref SceneObject::Materials).
+    uint32_t m_materialIndex = c_invalidMaterialIndex;
 };
 
+static_assert( std::is_trivially_copyable< HitRecord >::value, "HitRecord is expected to be trivially copyable." );
+
 RAYTRACE_NS_CLOSE
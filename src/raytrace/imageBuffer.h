@@ -75,6 +75,22 @@ public:
         return m_buffer[ ( i_y * m_width ) + i_x ];
     }
 
+    /// Get the pixel storage, in scanline order from the bottom of the image (y = 0) upwards.
+    ///
+    /// \return pointer to the first pixel.
+    inline const ValueT* Data() const
+    {
+        return m_buffer.data();
+    }
+
+    /// Get the pixel storage for writing, in scanline order from the bottom of the image (y = 0) upwards.
+    ///
+    /// \return pointer to the first pixel.
+    inline ValueT* Data()
+    {
+        return m_buffer.data();
+    }
+
     /// Resize the image buffer.
     ///
     /// If the new dimensions \p i_width and \p i_height are different from the current, the image will be resize.
@@ -8,41 +8,68 @@
 
 #include <raytrace/hitRecord.h>
 #include <raytrace/material.h>
-#include <raytrace/randomUnitVector.h>
+#include <raytrace/randomCosineDirection.h>
 
 RAYTRACE_NS_OPEN
 
+/// Scatter a ray off a lambertian surface, in a random direction about the surface normal, distributed by the cosine
+/// of the angle to the normal.
+///
+/// This is the kernel behind \ref Lambert::Scatter, exposed such that materials stored by value (see
+/// \ref MaterialRecord) can be scattered without virtual dispatch.
+///
+/// \param i_albedo The color of the surface.
+/// \param i_hitRecord The recorded hit information of the ray against the geometry.
+/// \param io_rng The random number generator to draw from.
+/// \param o_attenuation Color produced by the surface.
+/// \param o_scatteredRay The scattered ray.
+///
+/// \return Always true, as a lambertian surface scatters every incident ray.
+inline bool ScatterLambert( const gm::Vec3f&       i_albedo,
+                            const HitRecord&       i_hitRecord,
+                            RandomNumberGenerator& io_rng,
+                            gm::Vec3f&             o_attenuation,
+                            Ray&                   o_scatteredRay )
+{
+    // Produce random scatter direction, which is already of unit length.
+    o_scatteredRay = Ray( /* origin */ i_hitRecord.m_position,
+                          /* direction */ RandomCosineDirection( i_hitRecord.m_normal, io_rng ) );
+
+    // Apply albedo.
+    o_attenuation = i_albedo;
+
+    return true;
+}
+
 /// \class Lambert
 ///
-/// The lambert material scatters a ray towards a point within random unit sphere
-/// tangent to the hit point. (Improve on this definition?)
+/// The lambert material scatters a ray in a random direction about the surface normal, distributed by the cosine of
+/// the angle to the normal, as per an ideal diffuse surface.
 ///
 /// Lambert has an associated color attribute, named "albedo".
-class Lambert : public Material
+class Lambert final : public Material
 {
 public:
     /// Explicit constructor with albedo color.
     inline explicit Lambert( const gm::Vec3f& i_albedo )
-        : m_albedo( i_albedo )
+        : Material( MaterialType::Lambert )
+        , m_albedo( i_albedo )
     {
     }
 
-    inline virtual bool Scatter( const Ray&       i_ray,
-                                 const HitRecord& i_hitRecord,
-                                 gm::Vec3f&       o_attenuation,
-                                 Ray&             o_scatteredRay ) const override
+    /// Get the albedo color.
+    inline const gm::Vec3f& Albedo() const
     {
-        // Produce random scatter direction.
-        gm::Vec3f rayTarget = i_hitRecord.m_position + // From the hit point...
-                              i_hitRecord.m_normal +   // Add a unit in the direction of the normal.
-                              RandomUnitVector();      // Add random unit vector.
-        o_scatteredRay = Ray( /* origin */ i_hitRecord.m_position,
-                              /* direction */ gm::Normalize( rayTarget - i_hitRecord.m_position ) );
-
-        // Apply albedo.
-        o_attenuation = m_albedo;
+        return m_albedo;
+    }
 
-        return true;
+    inline virtual bool Scatter( const Ray&             i_ray,
+                                 const HitRecord&       i_hitRecord,
+                                 RandomNumberGenerator& io_rng,
+                                 gm::Vec3f&             o_attenuation,
+                                 Ray&                   o_scatteredRay ) const override
+    {
+        return ScatterLambert( m_albedo, i_hitRecord, io_rng, o_attenuation, o_scatteredRay );
     }
 
 private:
@@ -6,13 +6,50 @@
 
 #include <raytrace/raytrace.h>
 
+#include <raytrace/randomNumberGenerator.h>
 #include <raytrace/ray.h>
 
+#include <memory>
+
 RAYTRACE_NS_OPEN
 
 // Forward declarations.
 class HitRecord;
 
+/// \enum MaterialType
+///
+/// Identifies the concrete class of a material, such that hits can be grouped by material type and scattered in
+/// batches, without virtual dispatch.
+enum class MaterialType
+{
+    Lambert = 0, ///< \ref Lambert.
+    Metal,       ///< \ref Metal.
+    Dielectric,  ///< \ref Dielectric.
+    Other,       ///< Any other material, which is scattered through the virtual interface.
+    Count
+};
+
+/// \var c_materialTypeCount
+///
+/// The number of material types.
+constexpr int c_materialTypeCount = static_cast< int >( MaterialType::Count );
+
+/// Get the display name of the material type \p i_type.
+inline const char* MaterialTypeName( MaterialType i_type )
+{
+    switch ( i_type )
+    {
+    case MaterialType::Lambert:
+        return "lambert";
+    case MaterialType::Metal:
+        return "metal";
+    case MaterialType::Dielectric:
+        return "dielectric";
+    default:
+        return "other";
+    }
+}
+
 /// \class Material
 ///
 /// Material is the abstract base class of all material(s).  The purpose of a material is to define
@@ -20,24 +57,53 @@ class HitRecord;
 /// a new direction.
 ///
 /// A single material can be assigned to multiple scene objects.
+///
+/// Only the built-in material classes are tagged with their own \ref MaterialType.  Every other class is of
+/// \ref MaterialType::Other.
 class Material
 {
 public:
+    /// Construct a material of \ref MaterialType::Other.
+    inline Material() = default;
+
     /// Virtual de-constructor.
     virtual ~Material() = default;
 
+    /// Get the concrete type of this material.
+    inline MaterialType Type() const
+    {
+        return m_type;
+    }
+
     /// Scatter accepts an incident ray \p i_ray, and produces an attenutated color \p i_attenuation.
     /// The implementation may or may not produce a scattered ray \p o_scatteredRay.
     ///
     /// \param i_ray Incident ray.
     /// \param i_hitRecord The recorded hit information of the ray against the geometry.
+    /// \param io_rng The random number generator to draw from.
     /// \param o_attenuation Color produced based on the ray, by the material.
     /// \param o_scatteredRay The optional, scattered ray.
     ///
     /// \retval true If this material produces a scattered ray. \p o_scatteredRay will be populated.
     /// \retval false If this material absorbs the scattered ray.  \p o_scatteredRay will be undefined.
-    virtual bool
-    Scatter( const Ray& i_ray, const HitRecord& i_hitRecord, gm::Vec3f& o_attenuation, Ray& o_scatteredRay ) const = 0;
+    virtual bool Scatter( const Ray&             i_ray,
+                          const HitRecord&       i_hitRecord,
+                          RandomNumberGenerator& io_rng,
+                          gm::Vec3f&             o_attenuation,
+                          Ray&                   o_scatteredRay ) const = 0;
+
+private:
+    friend class Lambert;
+    friend class Metal;
+    friend class Dielectric;
+
+    // Construct a built-in material of the type \p i_type.
+    inline explicit Material( MaterialType i_type )
+        : m_type( i_type )
+    {
+    }
+
+    MaterialType m_type = MaterialType::Other;
 };
 
 /// \typedef MaterialSharedPtr
@@ -0,0 +1,219 @@
+#pragma once
+
+/// \file raytrace/materialTable.h
+///
+/// Closed, by-value representation of the materials of a scene, stored in a contiguous table.
+
+#include <raytrace/dielectric.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/lambert.h>
+#include <raytrace/material.h>
+#include <raytrace/metal.h>
+#include <raytrace/raytrace.h>
+
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class MaterialRecord
+///
+/// MaterialRecord is a tagged union over the parameters of the built-in material classes.  Scattering switches on
+/// the tag and calls the material kernel directly, which the compiler can inline, rather than a virtual call.
+///
+/// Materials of any other class are recorded by their address, and scattered through \ref Material::Scatter.
+class MaterialRecord
+{
+public:
+    /// Record the type and parameters of \p i_material.
+    ///
+    /// \param i_material The material to record.  Only materials of \ref MaterialType::Other are referenced by the
+    /// record, and must outlive it.  A null material is recorded as such, and cannot be scattered.
+    inline explicit MaterialRecord( const Material* i_material )
+        : m_type( MaterialType::Other )
+        , m_material( i_material )
+    {
+        // The concrete class is checked, once per material, such that the parameters are never read from an object
+        // of another class.
+        if ( const Lambert* lambert = dynamic_cast< const Lambert* >( i_material ) )
+        {
+            m_type             = MaterialType::Lambert;
+            m_lambert.m_albedo = lambert->Albedo();
+        }
+        else if ( const Metal* metal = dynamic_cast< const Metal* >( i_material ) )
+        {
+            m_type              = MaterialType::Metal;
+            m_metal.m_albedo    = metal->Albedo();
+            m_metal.m_fuzziness = metal->Fuzziness();
+        }
+        else if ( const Dielectric* dielectric = dynamic_cast< const Dielectric* >( i_material ) )
+        {
+            m_type                         = MaterialType::Dielectric;
+            m_dielectric.m_refractiveIndex = dielectric->RefractiveIndex();
+        }
+    }
+
+    /// Get the type of the recorded material.
+    inline MaterialType Type() const
+    {
+        return m_type;
+    }
+
+    /// Scatter the incident ray \p i_ray, as \ref Material::Scatter of the recorded material does.
+    inline bool Scatter( const Ray&             i_ray,
+                         const HitRecord&       i_hitRecord,
+                         RandomNumberGenerator& io_rng,
+                         gm::Vec3f&             o_attenuation,
+                         Ray&                   o_scatteredRay ) const
+    {
+        switch ( m_type )
+        {
+        case MaterialType::Lambert:
+            return ScatterLambert( m_lambert.m_albedo, i_hitRecord, io_rng, o_attenuation, o_scatteredRay );
+        case MaterialType::Metal:
+            return ScatterMetal( m_metal.m_albedo,
+                                 m_metal.m_fuzziness,
+                                 i_ray,
+                                 i_hitRecord,
+                                 io_rng,
+                                 o_attenuation,
+                                 o_scatteredRay );
+        case MaterialType::Dielectric:
+            return ScatterDielectric(
+                m_dielectric.m_refractiveIndex, i_ray, i_hitRecord, io_rng, o_attenuation, o_scatteredRay );
+        default:
+            return m_material->Scatter( i_ray, i_hitRecord, io_rng, o_attenuation, o_scatteredRay );
+        }
+    }
+
+private:
+    // Parameters of each built-in material type.
+    struct _LambertParameters
+    {
+        gm::Vec3f m_albedo;
+    };
+
+    struct _MetalParameters
+    {
+        gm::Vec3f m_albedo;
+        float     m_fuzziness;
+    };
+
+    struct _DielectricParameters
+    {
+        float m_refractiveIndex;
+    };
+
+    MaterialType m_type;
+    union
+    {
+        _LambertParameters    m_lambert;
+        _MetalParameters      m_metal;
+        _DielectricParameters m_dielectric;
+        const Material*       m_material;
+    };
+};
+
+static_assert( std::is_trivially_copyable< MaterialRecord >::value,
+               "MaterialRecord is expected to be trivially copyable." );
+
+/// \class MaterialTable
+///
+/// MaterialTable stores the materials of a scene by value, as \ref MaterialRecord(s) in a contiguous array.  Scene
+/// objects register their materials into a table (see \ref SceneObject::CompileMaterials), and report the index of
+/// the material in their hit records, through \ref HitRecord::m_materialIndex.
+///
+/// Materials shared between scene objects are de-duplicated.  The table holds a reference to every material added,
+/// such that the authored classes remain the means of describing a material.
+class MaterialTable final
+{
+public:
+    /// Find or insert the material \p i_material into the table.
+    ///
+    /// \return The index of the material record.
+    inline uint32_t Add( const MaterialSharedPtr& i_material )
+    {
+        auto it = m_indexMap.find( i_material.get() );
+        if ( it != m_indexMap.end() )
+        {
+            return it->second;
+        }
+
+        uint32_t materialIndex = static_cast< uint32_t >( m_records.size() );
+        m_records.push_back( MaterialRecord( i_material.get() ) );
+        m_materials.push_back( i_material );
+        m_indexMap[ i_material.get() ] = materialIndex;
+        return materialIndex;
+    }
+
+    /// Get the number of materials in the table.
+    inline size_t Size() const
+    {
+        return m_records.size();
+    }
+
+    /// Get the record of the material at \p i_materialIndex.
+    inline const MaterialRecord& Record( uint32_t i_materialIndex ) const
+    {
+        return m_records[ i_materialIndex ];
+    }
+
+    /// Get the authored material at \p i_materialIndex.
+    inline const MaterialSharedPtr& Source( uint32_t i_materialIndex ) const
+    {
+        return m_materials[ i_materialIndex ];
+    }
+
+private:
+    std::vector< MaterialRecord >                   m_records;
+    std::vector< MaterialSharedPtr >                m_materials;
+    std::unordered_map< const Material*, uint32_t > m_indexMap;
+};
+
+/// Get the type of the material hit by \p i_hitRecord.
+///
+/// \param i_materials The table which \p i_hitRecord indexes into, if any.
+/// \param i_hitRecord The hit.
+inline MaterialType HitMaterialType( const MaterialTable* i_materials, const HitRecord& i_hitRecord )
+{
+    if ( i_materials != nullptr && i_hitRecord.m_materialIndex != c_invalidMaterialIndex )
+    {
+        return i_materials->Record( i_hitRecord.m_materialIndex ).Type();
+    }
+
+    return i_hitRecord.m_material->Type();
+}
+
+/// Scatter the incident ray \p i_ray off the material hit by \p i_hitRecord.
+///
+/// The material is scattered by its record in \p i_materials, when the hit carries an index into it, otherwise through
+/// \ref Material::Scatter.
+///
+/// \param i_materials The table which \p i_hitRecord indexes into, if any.
+/// \param i_ray Incident ray.
+/// \param i_hitRecord The recorded hit information of the ray against the geometry.
+/// \param io_rng The random number generator to draw from.
+/// \param o_attenuation Color produced based on the ray, by the material.
+/// \param o_scatteredRay The optional, scattered ray.
+///
+/// \retval true If the material produces a scattered ray. \p o_scatteredRay will be populated.
+/// \retval false If the material absorbs the scattered ray.  \p o_scatteredRay will be undefined.
+inline bool ScatterHit( const MaterialTable*   i_materials,
+                        const Ray&             i_ray,
+                        const HitRecord&       i_hitRecord,
+                        RandomNumberGenerator& io_rng,
+                        gm::Vec3f&             o_attenuation,
+                        Ray&                   o_scatteredRay )
+{
+    if ( i_materials != nullptr && i_hitRecord.m_materialIndex != c_invalidMaterialIndex )
+    {
+        return i_materials->Record( i_hitRecord.m_materialIndex )
+            .Scatter( i_ray, i_hitRecord, io_rng, o_attenuation, o_scatteredRay );
+    }
+
+    return i_hitRecord.m_material->Scatter( i_ray, i_hitRecord, io_rng, o_attenuation, o_scatteredRay );
+}
+
+RAYTRACE_NS_CLOSE
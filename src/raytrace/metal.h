@@ -7,6 +7,7 @@
 #include <gm/types/vec3f.h>
 
 #include <gm/functions/clamp.h>
+#include <gm/functions/normalize.h>
 
 #include <raytrace/hitRecord.h>
 #include <raytrace/material.h>
@@ -15,6 +16,43 @@
 
 RAYTRACE_NS_OPEN
 
+/// Scatter a ray off a metal surface, as a reflection perturbed by \p i_fuzziness.
+///
+/// This is the kernel behind \ref Metal::Scatter, exposed such that materials stored by value (see
+/// \ref MaterialRecord) can be scattered without virtual dispatch.
+///
+/// \param i_albedo The color of the surface.
+/// \param i_fuzziness The radius of the random perturbation of the reflected direction, within [0, 1].
+/// \param i_ray Incident ray.
+/// \param i_hitRecord The recorded hit information of the ray against the geometry.
+/// \param io_rng The random number generator to draw from.
+/// \param o_attenuation Color produced by the surface.
+/// \param o_scatteredRay The scattered ray.
+///
+/// \retval true If the scattered ray leaves the surface.
+/// \retval false If the perturbed reflection is directed into the surface, and is thus absorbed.
+inline bool ScatterMetal( const gm::Vec3f&       i_albedo,
+                          float                  i_fuzziness,
+                          const Ray&             i_ray,
+                          const HitRecord&       i_hitRecord,
+                          RandomNumberGenerator& io_rng,
+                          gm::Vec3f&             o_attenuation,
+                          Ray&                   o_scatteredRay )
+{
+    gm::Vec3f reflectedDirection = Reflect( i_ray.Direction(), i_hitRecord.m_normal );
+    reflectedDirection += i_fuzziness * RandomUnitVector( io_rng );
+
+    // Produce reflected ray.
+    o_scatteredRay = Ray( /* origin */ i_hitRecord.m_position,
+                          /* direction */ gm::Normalize( reflectedDirection ) );
+
+    // Apply albedo.
+    o_attenuation = i_albedo;
+
+    // Produce scattered ray if the scattered ray is not orthogonal to the normal.
+    return ( gm::DotProduct( o_scatteredRay.Direction(), i_hitRecord.m_normal ) > 0 );
+}
+
 /// \class Metal
 ///
 /// The metal material reflects incoming rays "perfectly".
@@ -22,33 +60,36 @@ RAYTRACE_NS_OPEN
 /// Metal has the following parameters:
 /// - "albedo" color attribute.
 /// - "fuzziness" to impart randomness into the reflectance calcualtion.
-class Metal : public Material
+class Metal final : public Material
 {
 public:
     /// Explicit constructor with albedo color.
     inline explicit Metal( const gm::Vec3f& i_albedo, float i_fuzziness )
-        : m_albedo( i_albedo )
+        : Material( MaterialType::Metal )
+        , m_albedo( i_albedo )
         , m_fuzziness( gm::Clamp( i_fuzziness, gm::FloatRange( 0.0, 1.0 ) ) )
     {
     }
 
-    inline virtual bool Scatter( const Ray&       i_ray,
-                                 const HitRecord& i_hitRecord,
-                                 gm::Vec3f&       o_attenuation,
-                                 Ray&             o_scatteredRay ) const override
+    /// Get the albedo color.
+    inline const gm::Vec3f& Albedo() const
     {
-        gm::Vec3f reflectedDirection = Reflect( i_ray.Direction(), i_hitRecord.m_normal );
-        reflectedDirection += m_fuzziness * RandomUnitVector();
-
-        // Produce reflected ray.
-        o_scatteredRay = Ray( /* origin */ i_hitRecord.m_position,
-                              /* direction */ gm::Normalize( reflectedDirection ) );
+        return m_albedo;
+    }
 
-        // Apply albedo.
-        o_attenuation = m_albedo;
+    /// Get the fuzziness, clamped to [0, 1].
+    inline float Fuzziness() const
+    {
+        return m_fuzziness;
+    }
 
-        // Produce scattered ray if the scattered ray is not orthogonal to the normal.
-        return ( gm::DotProduct( o_scatteredRay.Direction(), i_hitRecord.m_normal ) > 0 );
+    inline virtual bool Scatter( const Ray&             i_ray,
+                                 const HitRecord&       i_hitRecord,
+                                 RandomNumberGenerator& io_rng,
+                                 gm::Vec3f&             o_attenuation,
+                                 Ray&                   o_scatteredRay ) const override
+    {
+        return ScatterMetal( m_albedo, m_fuzziness, i_ray, i_hitRecord, io_rng, o_attenuation, o_scatteredRay );
     }
 
 private:
@@ -0,0 +1,217 @@
+#pragma once
+
+/// \file raytrace/pathTracer.h
+///
+/// Iterative path tracing integrator.
+
+#include <raytrace/hitRecord.h>
+#include <raytrace/materialTable.h>
+#include <raytrace/randomNumberGenerator.h>
+#include <raytrace/ray.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/functions/clamp.h>
+#include <gm/functions/linearInterpolation.h>
+#include <gm/types/floatRange.h>
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+RAYTRACE_NS_OPEN
+
+/// \var c_indent
+///
+/// Indentation of each level of debug output, for a pixel, its samples, and their paths: 4 spaces.
+constexpr const char* c_indent = "    ";
+
+/// \class PathTracerSettings
+///
+/// Parameters controlling the construction of each path.
+class PathTracerSettings
+{
+public:
+    /// Maximum number of rays traced per path, including the camera ray.
+    int m_rayBounceLimit = 50;
+
+    /// The bounce from which paths are subject to Russian roulette termination.  0 disables Russian roulette.
+    int m_russianRouletteStartBounce = 0;
+
+    /// Range which the Russian roulette survival probability is clamped into.
+    ///
+    /// The minimum bounds the variance added by re-weighting surviving paths, whose throughput is divided by
+    /// the survival probability.
+    gm::FloatRange m_survivalProbabilityRange = gm::FloatRange( 0.05f, 1.0f );
+};
+
+/// \class PathStatistics
+///
+/// Counters accumulated over traced paths.
+class PathStatistics
+{
+public:
+    /// Number of paths traced.
+    size_t m_pathCount = 0;
+
+    /// Number of rays tested for scene intersection, across all paths.
+    size_t m_rayCount = 0;
+};
+
+/// Play Russian roulette with a path which has scattered at bounce \p i_bounce, re-weighting the throughput of a
+/// surviving path by the inverse of its survival probability.
+///
+/// Paths survive in proportion to their largest throughput channel, clamped into the survival probability range of
+/// \p i_settings.  A random number is drawn from \p io_rng only if the bounce is subject to Russian roulette.
+///
+/// \param i_settings The path construction parameters.
+/// \param i_bounce The bounce index of the path vertex which scattered.
+/// \param io_rng The random number generator of the path vertex.
+/// \param io_throughput The throughput of the path, including the attenuation of the scattering.
+///
+/// \return Whether the path survives.
+inline bool SurviveRussianRoulette( const PathTracerSettings& i_settings,
+                                    int                       i_bounce,
+                                    RandomNumberGenerator&    io_rng,
+                                    gm::Vec3f&                io_throughput )
+{
+    if ( i_settings.m_russianRouletteStartBounce <= 0 || i_bounce < i_settings.m_russianRouletteStartBounce )
+    {
+        return true;
+    }
+
+    float maxThroughput       = std::max( io_throughput[ 0 ], std::max( io_throughput[ 1 ], io_throughput[ 2 ] ) );
+    float survivalProbability = gm::Clamp( maxThroughput, i_settings.m_survivalProbabilityRange );
+    if ( io_rng.NextFloat() >= survivalProbability )
+    {
+        return false;
+    }
+
+    io_throughput /= survivalProbability;
+    return true;
+}
+
+/// Compute the background color seen by a ray escaping the scene, as a top-down gradient.
+///
+/// \param i_ray The escaping ray.
+///
+/// \return The background color.
+inline gm::Vec3f ComputeBackgroundColor( const Ray& i_ray )
+{
+    // Interpolate between two colors with the weight as the function of the ray direction.
+    float weight = 0.5f * i_ray.Direction().Y() + 1.0;
+    return gm::LinearInterpolation( gm::Vec3f( 1.0, 1.0, 1.0 ), gm::Vec3f( 0.5, 0.7, 1.0 ), weight );
+}
+
+/// Trace a path through \p i_scene starting with the camera ray \p i_ray, and compute the color it carries back.
+///
+/// Rather than recursing per bounce and applying the attenuation on the way back up, the path is extended in a
+/// loop carrying the running product of attenuations (the \em throughput).  The stack usage is constant in the
+/// bounce limit.
+///
+/// The random numbers of each path vertex are drawn from a stream keyed by its bounce index, starting from 1.
+///
+/// With Russian roulette enabled, paths whose throughput has diminished are terminated at random, with a survival
+/// probability proportional to the throughput.  Surviving paths are re-weighted by the inverse of the survival
+/// probability, thus the expected color is unchanged, while far fewer rays are traced through dim paths.
+///
+/// Hits are scattered through the material table of \p i_scene, when it has one (see \ref ScatterHit).
+///
+/// \param i_ray The camera ray.
+/// \param i_scene The scene to trace against.
+/// \param i_settings Path construction parameters.
+/// \param io_rng The random number generator of the pixel sample.
+/// \param io_statistics Optional counters to accumulate into.
+/// \param i_printDebug Print the path vertices to stdout.
+///
+/// \return The color of the path.
+inline gm::Vec3f TracePath( const Ray&                i_ray,
+                            const SceneObject&        i_scene,
+                            const PathTracerSettings& i_settings,
+                            RandomNumberGenerator&    io_rng,
+                            PathStatistics*           io_statistics = nullptr,
+                            bool                      i_printDebug  = false )
+{
+    // Fix for "Shadow acne" by culling hits which are too near.
+    const gm::FloatRange magnitudeRange( 0.001f, std::numeric_limits< float >::max() );
+
+    const MaterialTable* materials = i_scene.Materials();
+
+    Ray       ray = i_ray;
+    gm::Vec3f throughput( 1.0f, 1.0f, 1.0f );
+    gm::Vec3f color( 0.0f, 0.0f, 0.0f );
+    int       bounce = 1;
+    for ( ; bounce <= i_settings.m_rayBounceLimit; ++bounce )
+    {
+        if ( i_printDebug )
+        {
+            std::cout << c_indent << c_indent << ray << std::endl;
+            std::cout << c_indent << c_indent << "Bounce: " << bounce << std::endl;
+        }
+
+        HitRecord record;
+        if ( !i_scene.Hit( ray, magnitudeRange, record ) )
+        {
+            if ( i_printDebug )
+            {
+                std::cout << c_indent << c_indent << "Background colour!" << std::endl;
+            }
+
+            gm::Vec3f background = ComputeBackgroundColor( ray );
+            color = gm::Vec3f( throughput[ 0 ] * background[ 0 ],
+                               throughput[ 1 ] * background[ 1 ],
+                               throughput[ 2 ] * background[ 2 ] );
+            break;
+        }
+
+        if ( i_printDebug )
+        {
+            std::cout << c_indent << c_indent << "Hit" << std::endl
+                      << c_indent << c_indent << c_indent << "position: " << record.m_position << std::endl
+                      << c_indent << c_indent << c_indent << "normal: " << record.m_normal << std::endl;
+        }
+
+        Ray       scatteredRay;
+        gm::Vec3f attenuation;
+        io_rng.SetBounce( bounce );
+        if ( !ScatterHit( materials, ray, record, io_rng, attenuation, scatteredRay ) )
+        {
+            // Material has completely absorbed the ray, thus the path carries no color.
+            if ( i_printDebug )
+            {
+                std::cout << c_indent << c_indent << "Absorbed!" << std::endl;
+            }
+            break;
+        }
+
+        if ( i_printDebug )
+        {
+            std::cout << c_indent << c_indent << "Attenuation: " << attenuation << std::endl;
+        }
+
+        throughput = gm::Vec3f( throughput[ 0 ] * attenuation[ 0 ],
+                                throughput[ 1 ] * attenuation[ 1 ],
+                                throughput[ 2 ] * attenuation[ 2 ] );
+        ray        = scatteredRay;
+
+        if ( !SurviveRussianRoulette( i_settings, bounce, io_rng, throughput ) )
+        {
+            if ( i_printDebug )
+            {
+                std::cout << c_indent << c_indent << "Terminated by Russian roulette!" << std::endl;
+            }
+            break;
+        }
+    }
+
+    if ( io_statistics != nullptr )
+    {
+        io_statistics->m_pathCount++;
+        io_statistics->m_rayCount += std::min( bounce, i_settings.m_rayBounceLimit );
+    }
+
+    return color;
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,64 @@
+#pragma once
+
+/// \file raytrace/pfmImageWriter.h
+///
+/// Serialization of a linear, floating-point image into a PFM file on disk.
+
+#include <raytrace/imageBuffer.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec3f.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+RAYTRACE_NS_OPEN
+
+static_assert( sizeof( gm::Vec3f ) == 3 * sizeof( float ), "Vec3f is expected to be 3 tightly packed floats." );
+
+/// Check if the host stores multi-byte values little-endian first.
+inline bool IsLittleEndianHost()
+{
+    const uint32_t value = 1;
+    uint8_t        firstByte;
+    memcpy( &firstByte, &value, 1 );
+    return firstByte == 1;
+}
+
+/// Write the image \p i_image into file location \p i_filePath, as a color "PF" portable float map.
+///
+/// The channel values are written as is, without gamma correction, clamping, or quantization.  PFM scanlines are
+/// ordered bottom to top, as the pixels of \ref ImageBuffer are, and the byte order of the file is that of the host
+/// (recorded by the sign of the scale in the header).  Thus the image memory is written with a single call.
+///
+/// \param i_image the image buffer to write.
+/// \param i_filePath file location to save the PFM image.
+///
+/// \return success of writing the image.
+inline bool WritePFMImage( const RGBImageBuffer& i_image, const std::string& i_filePath )
+{
+    FILE* file = fopen( i_filePath.c_str(), "wb" );
+    if ( file == nullptr )
+    {
+        fprintf( stderr, "Cannot open file '%s' for writing!\n", i_filePath.c_str() );
+        return false;
+    }
+
+    // A negative scale denotes little-endian data.
+    const char* scale = IsLittleEndianHost() ? "-1.0" : "1.0";
+    bool        success = fprintf( file, "PF\n%d %d\n%s\n", i_image.Width(), i_image.Height(), scale ) > 0;
+
+    const size_t pixelCount = static_cast< size_t >( i_image.Width() ) * i_image.Height();
+    success = success && fwrite( i_image.Data(), sizeof( gm::Vec3f ), pixelCount, file ) == pixelCount;
+    success = ( fclose( file ) == 0 ) && success;
+    if ( !success )
+    {
+        fprintf( stderr, "Failed to write file '%s'!\n", i_filePath.c_str() );
+    }
+
+    return success;
+}
+
+RAYTRACE_NS_CLOSE
@@ -4,24 +4,117 @@
 ///
 /// Serialization of an image into a PPM file on disk.
 
+#include <gm/functions/clamp.h>
+#include <gm/types/floatRange.h>
 #include <gm/types/intRange.h>
+#include <gm/types/vec2iRange.h>
 
 #include <raytrace/imageBuffer.h>
 #include <raytrace/raytrace.h>
 
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 RAYTRACE_NS_OPEN
 
+/// \enum PPMEncoding
+///
+/// The encoding of the pixel data in a PPM file.
+enum class PPMEncoding
+{
+    ASCII = 0, ///< Plain "P3" encoding, with each channel value written as decimal text.
+    Binary     ///< Raw "P6" encoding, with each channel value written as a single byte.
+};
+
+/// \var c_ppmFileBufferSize
+///
+/// Size of the stdio buffer used when writing binary PPM files, such that the data reaches the operating system
+/// in few, large writes.
+constexpr size_t c_ppmFileBufferSize = 1 << 20;
+
+/// Convert the scanline \p i_yCoord of \p i_image into 8-bit RGB triplets.
+///
+/// \param i_image the image buffer to convert.
+/// \param i_yCoord the y-coordinate of the scanline.
+/// \param o_bytes destination of the converted scanline, with space for 3 * width bytes.
+///
+/// Channel values are clamped to [0,1] before conversion.
+inline void ConvertScanlineToRGB8( const RGBImageBuffer& i_image, int i_yCoord, uint8_t* o_bytes )
+{
+    const gm::FloatRange normalizedRange( 0.0f, 1.0f );
+    for ( int xCoord = 0; xCoord < i_image.Width(); ++xCoord )
+    {
+        const gm::Vec3f pixel = gm::Clamp( i_image( xCoord, i_yCoord ), normalizedRange );
+        o_bytes[ 0 ]          = static_cast< uint8_t >( 255.999f * pixel[ 0 ] );
+        o_bytes[ 1 ]          = static_cast< uint8_t >( 255.999f * pixel[ 1 ] );
+        o_bytes[ 2 ]          = static_cast< uint8_t >( 255.999f * pixel[ 2 ] );
+        o_bytes += 3;
+    }
+}
+
+/// Open \p i_filePath for binary writing, and write the "P6" header for \p i_image.
+///
+/// \param i_image the image buffer to write the header for.
+/// \param i_filePath file location to save the PPM image.
+///
+/// \return the opened file, or nullptr if the file could not be opened.
+inline FILE* OpenBinaryPPMFile( const RGBImageBuffer& i_image, const std::string& i_filePath )
+{
+    FILE* file = fopen( i_filePath.c_str(), "wb" );
+    if ( file == nullptr )
+    {
+        fprintf( stderr, "Cannot open file '%s' for writing!\n", i_filePath.c_str() );
+        return nullptr;
+    }
+
+    setvbuf( file, nullptr, _IOFBF, c_ppmFileBufferSize );
+    fprintf( file, "P6\n%d %d\n255\n", i_image.Width(), i_image.Height() );
+    return file;
+}
+
 /// A simple function for writing an image \p i_image into file location \p i_filePath.
 ///
+/// With binary encoding, the whole image is converted to bytes up front, then written with a single call.
+///
 /// \param i_image the image buffer to write.
 /// \param i_filePath file location to save the PPM image.
+/// \param i_encoding the encoding of the pixel data.
 ///
 /// \return success of writing the image.
-inline bool WritePPMImage( const RGBImageBuffer& i_image, const std::string& i_filePath )
+inline bool WritePPMImage( const RGBImageBuffer& i_image,
+                           const std::string&    i_filePath,
+                           PPMEncoding           i_encoding = PPMEncoding::Binary )
 {
+    if ( i_encoding == PPMEncoding::Binary )
+    {
+        FILE* file = OpenBinaryPPMFile( i_image, i_filePath );
+        if ( file == nullptr )
+        {
+            return false;
+        }
+
+        // PPM scanlines are ordered top to bottom.
+        const size_t           scanlineSize = 3 * static_cast< size_t >( i_image.Width() );
+        std::vector< uint8_t > bytes( scanlineSize * i_image.Height() );
+        for ( int yCoord = i_image.Height() - 1; yCoord >= 0; yCoord-- )
+        {
+            ConvertScanlineToRGB8( i_image, yCoord, bytes.data() + ( i_image.Height() - 1 - yCoord ) * scanlineSize );
+        }
+
+        bool success = fwrite( bytes.data(), 1, bytes.size(), file ) == bytes.size();
+        success      = ( fclose( file ) == 0 ) && success;
+        if ( !success )
+        {
+            fprintf( stderr, "Failed to write file '%s'!\n", i_filePath.c_str() );
+        }
+
+        return success;
+    }
+
     std::ofstream fileOutput( i_filePath.c_str(), std::ios::out | std::ios::trunc );
     if ( !fileOutput.is_open() )
     {
@@ -49,4 +142,141 @@ inline bool WritePPMImage( const RGBImageBuffer& i_image, const std::string& i_f
     return true;
 }
 
+/// \class PPMScanlineWriter
+///
+/// Writes a binary PPM image progressively, while it is being rendered.
+///
+/// The renderer reports each finished region of the image via \ref CompleteTile.  As soon as the next scanline
+/// in file order (top to bottom) is complete, it is converted and written out, such that file I/O overlaps
+/// with the rendering of the remaining tiles.
+///
+/// Only one thread writes to the file at a time.  Other threads completing tiles in the meantime merely
+/// record their progress, which is picked up by the writing thread before it returns.
+class PPMScanlineWriter final
+{
+public:
+    /// Construct a writer for the image \p i_image, which must outlive the writer.
+    ///
+    /// \param i_image the image buffer being rendered.
+    explicit inline PPMScanlineWriter( const RGBImageBuffer& i_image )
+        : m_image( i_image )
+        , m_rowPixelCounts( i_image.Height(), 0 )
+        , m_nextRow( i_image.Height() - 1 )
+        , m_scanlineBytes( 3 * static_cast< size_t >( i_image.Width() ) )
+    {
+    }
+
+    PPMScanlineWriter( const PPMScanlineWriter& ) = delete;
+    PPMScanlineWriter& operator=( const PPMScanlineWriter& ) = delete;
+
+    inline ~PPMScanlineWriter()
+    {
+        if ( m_file != nullptr )
+        {
+            fclose( m_file );
+        }
+    }
+
+    /// Open \p i_filePath for writing, and write the PPM header.
+    ///
+    /// \param i_filePath file location to save the PPM image.
+    ///
+    /// \return success of opening the file.
+    inline bool Open( const std::string& i_filePath )
+    {
+        m_filePath = i_filePath;
+        m_file     = OpenBinaryPPMFile( m_image, i_filePath );
+        return m_file != nullptr;
+    }
+
+    /// Record that all the pixels within \p i_tile have been rendered, and write out any scanlines which
+    /// are now complete.
+    ///
+    /// This is safe to call concurrently from multiple threads.
+    ///
+    /// \param i_tile the completed region of the image.
+    inline void CompleteTile( const gm::Vec2iRange& i_tile )
+    {
+        {
+            std::lock_guard< std::mutex > lock( m_mutex );
+            for ( int yCoord = i_tile.Min().Y(); yCoord < i_tile.Max().Y(); ++yCoord )
+            {
+                m_rowPixelCounts[ yCoord ] += i_tile.Max().X() - i_tile.Min().X();
+            }
+
+            if ( m_writing || m_file == nullptr )
+            {
+                return;
+            }
+
+            m_writing = true;
+        }
+
+        _WriteCompleteRows();
+    }
+
+    /// Flush & close the file.  All the scanlines of the image must have been completed.
+    ///
+    /// \return success of writing the image.
+    inline bool Close()
+    {
+        if ( m_file == nullptr )
+        {
+            return false;
+        }
+
+        bool success = ( m_nextRow < 0 ) && !m_error;
+        success      = ( fclose( m_file ) == 0 ) && success;
+        m_file       = nullptr;
+        if ( !success )
+        {
+            fprintf( stderr, "Failed to write file '%s'!\n", m_filePath.c_str() );
+        }
+
+        return success;
+    }
+
+private:
+    // Write out complete scanlines in file order, until the next scanline is incomplete.
+    // Only called by the thread which set m_writing.
+    inline void _WriteCompleteRows()
+    {
+        while ( true )
+        {
+            int yCoord;
+            {
+                std::lock_guard< std::mutex > lock( m_mutex );
+                if ( m_nextRow < 0 || m_rowPixelCounts[ m_nextRow ] < m_image.Width() )
+                {
+                    m_writing = false;
+                    return;
+                }
+
+                yCoord = m_nextRow--;
+            }
+
+            // The scanline pixels are no longer written by any thread, so it can be read outside of the lock.
+            ConvertScanlineToRGB8( m_image, yCoord, m_scanlineBytes.data() );
+            if ( fwrite( m_scanlineBytes.data(), 1, m_scanlineBytes.size(), m_file ) != m_scanlineBytes.size() )
+            {
+                m_error = true;
+            }
+        }
+    }
+
+    const RGBImageBuffer& m_image;
+    std::string           m_filePath;
+    FILE*                 m_file = nullptr;
+
+    // Guards the row progress below.
+    std::mutex         m_mutex;
+    std::vector< int > m_rowPixelCounts;
+    int                m_nextRow = 0;
+    bool               m_writing = false;
+
+    // Accessed only by the writing thread.
+    std::vector< uint8_t > m_scanlineBytes;
+    bool                   m_error = false;
+};
+
 RAYTRACE_NS_CLOSE
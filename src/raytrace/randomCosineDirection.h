@@ -0,0 +1,41 @@
+#pragma once
+
+/// \file raytrace/randomCosineDirection.h
+///
+/// Utility for generating a random direction about a surface normal, distributed by the cosine of the angle to the
+/// normal.
+
+#include <raytrace/raytrace.h>
+
+#include <raytrace/randomNumberGenerator.h>
+#include <raytrace/sampleMapping.h>
+
+#include <gm/functions/coordinateSystem.h>
+#include <gm/types/vec2f.h>
+#include <gm/types/vec3f.h>
+
+RAYTRACE_NS_OPEN
+
+/// Compute a random unit vector in the hemisphere about \p i_normal, with probability density proportional to the
+/// cosine of the angle to \p i_normal.
+///
+/// The direction is sampled about the Z axis (see \ref CosineHemisphereSample), then transformed into the
+/// orthonormal frame of \p i_normal.  Thus it is of unit length by construction, and is never degenerate.
+///
+/// \param i_normal The unit length surface normal.
+/// \param io_rng The random number generator to draw from.
+///
+/// \return Random unit vector.
+inline gm::Vec3f RandomCosineDirection( const gm::Vec3f& i_normal, RandomNumberGenerator& io_rng )
+{
+    const float     xSample   = io_rng.NextFloat();
+    const float     ySample   = io_rng.NextFloat();
+    const gm::Vec3f direction = CosineHemisphereSample( gm::Vec2f( xSample, ySample ) );
+
+    gm::Vec3f tangent;
+    gm::Vec3f bitangent;
+    gm::CoordinateSystem( i_normal, tangent, bitangent );
+    return direction.X() * tangent + direction.Y() * bitangent + direction.Z() * i_normal;
+}
+
+RAYTRACE_NS_CLOSE
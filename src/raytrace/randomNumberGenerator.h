@@ -0,0 +1,131 @@
+#pragma once
+
+/// \file raytrace/randomNumberGenerator.h
+///
+/// Counter-based random number generation, keyed by pixel, sample, and bounce.
+
+#include <raytrace/raytrace.h>
+#include <raytrace/sampler.h>
+
+#include <gm/types/floatRange.h>
+
+#include <cstdint>
+
+RAYTRACE_NS_OPEN
+
+/// \var c_samplerDimensionsPerBounce
+///
+/// The number of draws of each bounce taken from the \ref Sampler of a \ref RandomNumberGenerator.  Covers the
+/// pixel & lens samples of the camera, and the scattering & Russian roulette draws of each path vertex.
+constexpr uint32_t c_samplerDimensionsPerBounce = 4;
+
+/// \class RandomNumberGenerator
+///
+/// A counter-based random number generator.  Rather than advancing a large internal state, each number is
+/// produced by hashing a \em key together with a \em counter:
+/// - The key is derived from the seed, pixel index, and sample index.
+/// - The counter is composed of the current bounce (high 32 bits), and the number of draws made within
+///   that bounce (low 32 bits).
+///
+/// As a result, the random numbers consumed by a given pixel sample are independent of which thread renders it,
+/// or in which order, producing bit-reproducible images for any thread count.  Keying by bounce also means that
+/// the numbers used at a bounce do not depend on how many numbers were drawn at previous bounces.
+///
+/// Optionally, the first \ref c_samplerDimensionsPerBounce draws of each bounce are taken from a \ref Sampler
+/// instead, as dimensions of the pixel sample, such that the samples of a pixel are spread more evenly.  Further
+/// draws within a bounce fall back to hashing.
+///
+/// The state is small, so a generator is cheap to construct per pixel sample, on the stack.
+class RandomNumberGenerator final
+{
+public:
+    /// Construct a generator for a single pixel sample.
+    ///
+    /// \param i_pixelIndex The linear index of the pixel.
+    /// \param i_sampleIndex The index of the sample within the pixel.
+    /// \param i_seed Seed, to produce a different sequence for an otherwise identical render.
+    /// \param i_sampler Optional sampler to draw the leading dimensions of each bounce from.  Must outlive the
+    /// generator.
+    inline explicit RandomNumberGenerator( uint32_t       i_pixelIndex,
+                                           uint32_t       i_sampleIndex,
+                                           uint32_t       i_seed    = 0,
+                                           const Sampler* i_sampler = nullptr )
+        : m_key( _Mix( _Mix( _Mix( i_seed ) ^ i_pixelIndex ) ^ ( static_cast< uint64_t >( i_sampleIndex ) << 32 ) ) )
+        , m_sampler( i_sampler )
+        , m_pixelIndex( i_pixelIndex )
+        , m_sampleIndex( i_sampleIndex )
+    {
+    }
+
+    /// Position the generator at the beginning of the random stream for bounce \p i_bounce.
+    ///
+    /// Bounce 0 is used for camera (pixel & lens) sampling, thus path vertices should start from 1.
+    ///
+    /// \param i_bounce The bounce index.
+    inline void SetBounce( uint32_t i_bounce )
+    {
+        m_counter = static_cast< uint64_t >( i_bounce ) << 32;
+    }
+
+    /// Generate a uniformly distributed 32-bit unsigned integer.
+    ///
+    /// \return Random integer.
+    inline uint32_t NextUInt()
+    {
+        return static_cast< uint32_t >( _Mix( m_key + ( m_counter++ ) * c_weylIncrement ) >> 32 );
+    }
+
+    /// Generate a uniformly distributed number in the half-open range [0, 1).
+    ///
+    /// \return Random number.
+    inline float NextFloat()
+    {
+        if ( m_sampler != nullptr )
+        {
+            const uint32_t drawIndex = static_cast< uint32_t >( m_counter );
+            if ( drawIndex < c_samplerDimensionsPerBounce )
+            {
+                const uint32_t bounce = static_cast< uint32_t >( m_counter >> 32 );
+                ++m_counter;
+                return m_sampler->Sample1D(
+                    m_pixelIndex, m_sampleIndex, bounce * c_samplerDimensionsPerBounce + drawIndex );
+            }
+        }
+
+        // The upper 24 bits fill the float mantissa exactly.
+        return static_cast< float >( NextUInt() >> 8 ) * c_inverse24Bits;
+    }
+
+    /// Generate a uniformly distributed number within \p i_range.
+    ///
+    /// \param i_range Range to limit the generated number.
+    ///
+    /// \return Random number.
+    inline float NextFloat( const gm::FloatRange& i_range )
+    {
+        return i_range.Min() + NextFloat() * ( i_range.Max() - i_range.Min() );
+    }
+
+private:
+    // Golden ratio increment, to decorrelate consecutive counters before mixing.
+    static constexpr uint64_t c_weylIncrement = 0x9E3779B97F4A7C15ull;
+
+    // 2^-24.
+    static constexpr float c_inverse24Bits = 1.0f / 16777216.0f;
+
+    // 64-bit finalizer from SplitMix64, with full avalanche.
+    static inline uint64_t _Mix( uint64_t i_value )
+    {
+        i_value = ( i_value ^ ( i_value >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+        i_value = ( i_value ^ ( i_value >> 27 ) ) * 0x94D049BB133111EBull;
+        return i_value ^ ( i_value >> 31 );
+    }
+
+    uint64_t       m_key         = 0;
+    uint64_t       m_counter     = 0;
+    const Sampler* m_sampler     = nullptr;
+    uint32_t       m_pixelIndex  = 0;
+    uint32_t       m_sampleIndex = 0;
+};
+
+RAYTRACE_NS_CLOSE
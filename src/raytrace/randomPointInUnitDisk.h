@@ -9,26 +9,27 @@
 
 #include <raytrace/raytrace.h>
 
-#include <gm/base/constants.h>
-#include <gm/functions/randomNumber.h>
-#include <gm/types/floatRange.h>
+#include <raytrace/randomNumberGenerator.h>
+#include <raytrace/sampleMapping.h>
+
+#include <gm/types/vec2f.h>
 #include <gm/types/vec3f.h>
 
 RAYTRACE_NS_OPEN
 
-/// Generate an random point in a unit disk.
+/// Generate a random point in a unit disk, uniformly distributed by area.
+///
+/// The point is the concentric mapping of two draws, see \ref ConcentricDiskSample.
+///
+/// \param io_rng The random number generator to draw from.
 ///
 /// \return Random point in the unit disk.
-inline gm::Vec3f RandomPointInUnitDisk()
+inline gm::Vec3f RandomPointInUnitDisk( RandomNumberGenerator& io_rng )
 {
-    // Random angle & magnitude
-    float angle     = gm::RandomNumber( gm::FloatRange( 0.0f, 2.0f * gm::Pi ) );
-    float magnitude = gm::RandomNumber( gm::FloatRange( 0.0f, 1.0f ) );
-
-    // Compute the cosine and sine for the x & y coordinates based on the random angle,
-    // scaled by the random magintude.
-    // TODO: Check if this actually produces uniform random-ness?
-    return gm::Vec3f( cos( angle ) * magnitude, sin( angle ) * magnitude, 0.0f );
+    const float     xSample = io_rng.NextFloat();
+    const float     ySample = io_rng.NextFloat();
+    const gm::Vec2f point   = ConcentricDiskSample( gm::Vec2f( xSample, ySample ) );
+    return gm::Vec3f( point.X(), point.Y(), 0.0f );
 }
 
 RAYTRACE_NS_CLOSE
@@ -6,24 +6,33 @@
 
 #include <raytrace/raytrace.h>
 
+#include <raytrace/randomNumberGenerator.h>
+
 #include <gm/base/constants.h>
-#include <gm/functions/randomNumber.h>
-#include <gm/types/floatRange.h>
 #include <gm/types/vec3f.h>
 
+#include <algorithm>
+#include <cmath>
+
 RAYTRACE_NS_OPEN
 
-/// Compute a random 3D unit vector.
+/// Compute a random 3D unit vector, uniformly distributed over the unit sphere.
+///
+/// The angle around the Z axis is drawn first, then the height, which by Archimedes' hat-box theorem is itself
+/// uniformly distributed.
+///
+/// Vectors are drawn one at a time, thus the sine & cosine are computed by libm, which is as fast as the scalar
+/// polynomial of \ref UniformSphereSample.  Only the batch kernels of the latter are faster.
 ///
-/// TODO - write a proof for this.
+/// \param io_rng The random number generator to draw from.
 ///
 /// \return Random unit vector.
-inline gm::Vec3f RandomUnitVector()
+inline gm::Vec3f RandomUnitVector( RandomNumberGenerator& io_rng )
 {
-    float angle = gm::RandomNumber( gm::FloatRange( 0.0f, 2.0f * gm::Pi ) );
-    float z     = gm::RandomNumber( gm::FloatRange( -1.0f, 1.0f ) );
-    float r     = sqrt( 1.0f - z * z );
-    return gm::Vec3f( r * cos( angle ), r * sin( angle ), z );
+    const float angle  = io_rng.NextFloat() * 2.0f * gm::Pi;
+    const float z      = io_rng.NextFloat() * 2.0f - 1.0f;
+    const float radius = std::sqrt( std::max( 0.0f, 1.0f - z * z ) );
+    return gm::Vec3f( radius * std::cos( angle ), radius * std::sin( angle ), z );
 }
 
 RAYTRACE_NS_CLOSE
@@ -0,0 +1,410 @@
+/// \file raytrace/renderOptions.cpp
+
+#include <raytrace/renderOptions.h>
+
+#include <raytrace/adaptiveSampling.h>
+#include <raytrace/checkpoint.h>
+#include <raytrace/exrImageWriter.h>
+#include <raytrace/imageBuffer.h>
+#include <raytrace/pfmImageWriter.h>
+#include <raytrace/ppmImageWriter.h>
+#include <raytrace/renderer.h>
+
+#include <gm/types/floatRange.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+
+RAYTRACE_NS_OPEN
+
+void AddRenderOptions( cxxopts::Options& io_options )
+{
+    io_options.add_options()                                                                    // Command line options.
+        ( "w,width", "Width of the image.", cxxopts::value< int >()->default_value( "384" ) )   // Width
+        ( "h,height", "Height of the image.", cxxopts::value< int >()->default_value( "256" ) ) // Height;
+        ( "o,output",
+          "Output file.  The format is deduced from the extension: .pfm and .exr write linear float channels, without "
+          "gamma correction or clamping.  Otherwise, 8-bit PPM is written.",
+          cxxopts::value< std::string >()->default_value( "out.ppm" ) ) // Output file.
+        ( "s,samplesPerPixel",
+          "Number of samples per-pixel.  With adaptive sampling, this is the maximum number of samples.",
+          cxxopts::value< int >()->default_value( "100" ) ) // Number of samples.
+        ( "adaptive",
+          "Turn on adaptive sampling, which stops sampling a pixel once its estimated error is low enough.",
+          cxxopts::value< bool >()->default_value( "false" ) ) // Adaptive sampling.
+        ( "minSamplesPerPixel",
+          "Minimum number of samples per-pixel, with adaptive sampling.",
+          cxxopts::value< int >()->default_value( "16" ) ) // Minimum number of samples.
+        ( "errorThreshold",
+          "Relative error of the pixel luminance (at 95% confidence) below which adaptive sampling stops.",
+          cxxopts::value< float >()->default_value( "0.05" ) ) // Adaptive sampling threshold.
+        ( "sampler",
+          "Sequence to draw the pixel, lens, and scattering samples from: \"independent\" random numbers, "
+          "\"stratified\", Owen-scrambled \"sobol\", or \"blueNoise\" for Sobol offset per-pixel by a blue noise "
+          "mask.",
+          cxxopts::value< std::string >()->default_value( "independent" ) ) // Sampler.
+        ( "sampleCountOutput",
+          "Optional output file for a heat map of the number of samples taken per-pixel.",
+          cxxopts::value< std::string >()->default_value( "" ) ) // Sample count heat map.
+        ( "b,rayBounceLimit",
+          "Number of bounces possible for a ray until termination.",
+          cxxopts::value< int >()->default_value( "50" ) ) // Maximum number of light bounces before termination.
+        ( "russianRoulette",
+          "The bounce from which paths may be terminated early by Russian roulette, based on their throughput.  "
+          "0 disables Russian roulette.",
+          cxxopts::value< int >()->default_value( "0" ) ) // Russian roulette start bounce.
+        ( "minSurvivalProbability",
+          "Lower bound of the Russian roulette survival probability.",
+          cxxopts::value< float >()->default_value( "0.05" ) ) // Survival probability clamp.
+        ( "maxSurvivalProbability",
+          "Upper bound of the Russian roulette survival probability.",
+          cxxopts::value< float >()->default_value( "1" ) ) // Survival probability clamp.
+        ( "progressive",
+          "Render in passes of 1, 2, 4, ... samples per-pixel, writing a snapshot of the image between passes.",
+          cxxopts::value< bool >()->default_value( "false" ) ) // Progressive rendering.
+        ( "snapshotInterval",
+          "Minimum seconds between progressive snapshots.  0 writes a snapshot after every pass, and a negative "
+          "interval writes none.",
+          cxxopts::value< double >()->default_value( "0" ) ) // Snapshot interval.
+        ( "timeLimit",
+          "Seconds after which a progressive render stops, keeping the image of the last complete pass.  Implies "
+          "--progressive.  0 for no limit.",
+          cxxopts::value< double >()->default_value( "0" ) ) // Time limit.
+        ( "checkpoint",
+          "Optional file to periodically write the accumulated samples into, from which an interrupted render can "
+          "resume with --resume.  Implies --progressive.",
+          cxxopts::value< std::string >()->default_value( "" ) ) // Checkpoint file.
+        ( "checkpointInterval",
+          "Minimum seconds between checkpoints.  A checkpoint is also written once the render stops.",
+          cxxopts::value< double >()->default_value( "60" ) ) // Checkpoint interval.
+        ( "resume",
+          "Resume the render from the --checkpoint file, if it exists.  The image is identical to that of an "
+          "uninterrupted render.",
+          cxxopts::value< bool >()->default_value( "false" ) ) // Resume from checkpoint.
+        ( "wavefront",
+          "Trace the paths of each tile in batches, one stage at a time, with hits grouped by material type.",
+          cxxopts::value< bool >()->default_value( "false" ) ) // Wavefront integrator.
+        ( "t,threads",
+          "Number of worker threads used for rendering.  0 will use all available hardware threads.",
+          cxxopts::value< int >()->default_value( "0" ) ) // Thread count.
+        ( "seed",
+          "Seed for the per-pixel random number generators.  Renders with the same seed are identical, regardless "
+          "of thread count.",
+          cxxopts::value< uint32_t >()->default_value( "0" ) ) // Seed.
+        ( "statistics",
+          "Print per-thread busy and idle time, and sample & ray counts after rendering.",
+          cxxopts::value< bool >()->default_value( "false" ) )                                   // Statistics.
+        ( "d,debug", "Turn on debug mode.", cxxopts::value< bool >()->default_value( "false" ) ) // Debug mode.
+        ( "x,debugXCoord",
+          "The x-coordinate of the pixel in the image to print debug information for.",
+          cxxopts::value< int >()->default_value( "0" ) ) // Xcoord.
+        ( "y,debugYCoord",
+          "The y-coordinate of the pixel in the image to print debug information for.",
+          cxxopts::value< int >()->default_value( "0" ) ); // Ycoord.
+}
+
+ImageFileFormat ImageFileFormatFromPath( const std::string& i_filePath )
+{
+    const size_t extensionBegin = i_filePath.rfind( '.' );
+    if ( extensionBegin == std::string::npos )
+    {
+        return ImageFileFormat::PPM;
+    }
+
+    std::string extension = i_filePath.substr( extensionBegin + 1 );
+    std::transform( extension.begin(), extension.end(), extension.begin(), []( unsigned char i_char ) {
+        return static_cast< char >( std::tolower( i_char ) );
+    } );
+    if ( extension == "pfm" )
+    {
+        return ImageFileFormat::PFM;
+    }
+    else if ( extension == "exr" )
+    {
+        return ImageFileFormat::EXR;
+    }
+
+    return ImageFileFormat::PPM;
+}
+
+bool ParseRenderOptions( const cxxopts::ParseResult& i_args, RenderOptions& o_options )
+{
+    RenderOptions options;
+    options.m_imageWidth                = i_args[ "width" ].as< int >();
+    options.m_imageHeight               = i_args[ "height" ].as< int >();
+    options.m_outputPath                = i_args[ "output" ].as< std::string >();
+    options.m_outputFormat              = ImageFileFormatFromPath( options.m_outputPath );
+    options.m_sampleCountOutputPath     = i_args[ "sampleCountOutput" ].as< std::string >();
+    options.m_snapshotIntervalSeconds   = i_args[ "snapshotInterval" ].as< double >();
+    options.m_checkpointPath            = i_args[ "checkpoint" ].as< std::string >();
+    options.m_checkpointIntervalSeconds = i_args[ "checkpointInterval" ].as< double >();
+    options.m_resume                    = i_args[ "resume" ].as< bool >();
+    options.m_printStatistics           = i_args[ "statistics" ].as< bool >();
+    options.m_debug                     = i_args[ "debug" ].as< bool >();
+
+    // Debug coordinates are specified from the top of the image, as the pixels are displayed.
+    options.m_debugPixelCoord = gm::Vec2i( i_args[ "debugXCoord" ].as< int >(),
+                                           options.m_imageHeight - 1 - i_args[ "debugYCoord" ].as< int >() );
+
+    RenderSettings& settings = options.m_renderSettings;
+    settings.m_seed          = i_args[ "seed" ].as< uint32_t >();
+    settings.m_threadCount   = i_args[ "threads" ].as< int >();
+
+    // Fixed-rate sampling is adaptive sampling with equal minimum & maximum sample counts.
+    const int  samplesPerPixel               = i_args[ "samplesPerPixel" ].as< int >();
+    const bool adaptive                      = i_args[ "adaptive" ].as< bool >();
+    const int  minSamplesPerPixel            = i_args[ "minSamplesPerPixel" ].as< int >();
+    settings.m_sampling.m_maxSamplesPerPixel = samplesPerPixel;
+    settings.m_sampling.m_minSamplesPerPixel = adaptive ? std::min( minSamplesPerPixel, samplesPerPixel )
+                                                        : samplesPerPixel;
+    settings.m_sampling.m_errorThreshold     = i_args[ "errorThreshold" ].as< float >();
+
+    const std::string samplerName = i_args[ "sampler" ].as< std::string >();
+    if ( !SamplerTypeFromName( samplerName, settings.m_sampler ) )
+    {
+        fprintf( stderr,
+                 "Unknown sampler '%s', expected one of independent, stratified, sobol, or blueNoise!\n",
+                 samplerName.c_str() );
+        return false;
+    }
+
+    settings.m_pathTracer.m_rayBounceLimit             = i_args[ "rayBounceLimit" ].as< int >();
+    settings.m_pathTracer.m_russianRouletteStartBounce = i_args[ "russianRoulette" ].as< int >();
+
+    // The survival probabilities clamp a probability, thus must form a non-empty range within (0,1].
+    const float minSurvivalProbability = i_args[ "minSurvivalProbability" ].as< float >();
+    const float maxSurvivalProbability = i_args[ "maxSurvivalProbability" ].as< float >();
+    if ( !( minSurvivalProbability > 0.0f && minSurvivalProbability <= maxSurvivalProbability &&
+            maxSurvivalProbability <= 1.0f ) )
+    {
+        fprintf( stderr,
+                 "Survival probabilities must satisfy 0 < min <= max <= 1, but min is %g and max is %g!\n",
+                 minSurvivalProbability,
+                 maxSurvivalProbability );
+        return false;
+    }
+
+    settings.m_pathTracer.m_survivalProbabilityRange = gm::FloatRange( minSurvivalProbability, maxSurvivalProbability );
+    settings.m_wavefront                             = i_args[ "wavefront" ].as< bool >();
+
+    // A time limit can only be met by stopping between passes, which is also when checkpoints are written.
+    settings.m_timeLimitSeconds = i_args[ "timeLimit" ].as< double >();
+    settings.m_progressive      = i_args[ "progressive" ].as< bool >() || settings.m_timeLimitSeconds > 0.0 ||
+                                  !options.m_checkpointPath.empty();
+
+    // Floating-point formats store the linear colors, for compositing.
+    settings.m_linearOutput = options.m_outputFormat != ImageFileFormat::PPM;
+
+    o_options = options;
+    return true;
+}
+
+/// Print the thread, sample & ray counts of a render.
+///
+/// \param i_statistics The counters of the render.
+/// \param i_pixelCount The number of pixels rendered.
+static void PrintRenderStatistics( const RenderStatistics& i_statistics, int i_pixelCount )
+{
+    if ( i_statistics.m_passCount > 1 || i_statistics.m_timeLimitReached )
+    {
+        std::cout << "Passes: " << i_statistics.m_passCount
+                  << ( i_statistics.m_timeLimitReached ? " (time limit reached)" : "" ) << std::endl;
+    }
+
+    for ( size_t workerIndex = 0; workerIndex < i_statistics.m_workers.size(); ++workerIndex )
+    {
+        const WorkerStatistics& worker = i_statistics.m_workers[ workerIndex ];
+        std::cout << "Thread " << workerIndex << ": " << std::fixed << std::setprecision( 3 ) << "busy "
+                  << worker.m_busySeconds << "s, "
+                  << "idle " << worker.m_idleSeconds << "s, "
+                  << "tiles " << worker.m_tasksExecuted << " (" << worker.m_tasksStolen << " stolen)" << std::endl;
+    }
+
+    std::cout << "Samples: " << i_statistics.m_sampleCount << " (" << std::setprecision( 2 )
+              << ( double ) i_statistics.m_sampleCount / i_pixelCount << " per-pixel)" << std::endl;
+    if ( i_statistics.m_paths.m_pathCount > 0 )
+    {
+        std::cout << "Rays: " << i_statistics.m_paths.m_rayCount << " ("
+                  << ( double ) i_statistics.m_paths.m_rayCount / i_statistics.m_paths.m_pathCount << " per-path)"
+                  << std::endl;
+    }
+
+    const WavefrontStatistics& wavefront = i_statistics.m_wavefront;
+    if ( wavefront.m_intersectionCount > 0 )
+    {
+        std::cout << "Intersect: " << wavefront.m_intersectionCount << " rays, " << std::setprecision( 3 )
+                  << wavefront.m_intersectionSeconds << "s ("
+                  << wavefront.m_intersectionCount / wavefront.m_intersectionSeconds * 1e-6 << " Mrays/s)" << std::endl;
+        std::cout << "Sort: " << wavefront.m_sortSeconds << "s" << std::endl;
+        for ( int typeIndex = 0; typeIndex < c_materialTypeCount; ++typeIndex )
+        {
+            if ( wavefront.m_scatterCounts[ typeIndex ] == 0 )
+            {
+                continue;
+            }
+
+            std::cout << "Scatter " << MaterialTypeName( static_cast< MaterialType >( typeIndex ) ) << ": "
+                      << wavefront.m_scatterCounts[ typeIndex ] << " hits, " << wavefront.m_scatterSeconds[ typeIndex ]
+                      << "s ("
+                      << wavefront.m_scatterCounts[ typeIndex ] / wavefront.m_scatterSeconds[ typeIndex ] * 1e-6
+                      << " Mhits/s)" << std::endl;
+        }
+    }
+}
+
+/// Write the image \p i_image into file location \p i_filePath, in the format \p i_format.
+///
+/// \return success of writing the image.
+static bool WriteImageFile( const RGBImageBuffer& i_image, const std::string& i_filePath, ImageFileFormat i_format )
+{
+    switch ( i_format )
+    {
+    case ImageFileFormat::PFM:
+        return WritePFMImage( i_image, i_filePath );
+    case ImageFileFormat::EXR:
+        return WriteEXRImage( i_image, i_filePath );
+    default:
+        return WritePPMImage( i_image, i_filePath );
+    }
+}
+
+/// Check if a checkpoint file exists at \p i_filePath.
+static bool CheckpointExists( const std::string& i_filePath )
+{
+    FILE* file = fopen( i_filePath.c_str(), "rb" );
+    if ( file == nullptr )
+    {
+        return false;
+    }
+
+    fclose( file );
+    return true;
+}
+
+bool RenderImageFile( const RenderOptions& i_options, const Camera& i_camera, const SceneObject& i_scene )
+{
+    // Allocate the image to write into.
+    RGBImageBuffer image( i_options.m_imageWidth, i_options.m_imageHeight );
+
+    Renderer renderer( i_options.m_renderSettings );
+    if ( i_options.m_resume && !i_options.m_checkpointPath.empty() && CheckpointExists( i_options.m_checkpointPath ) )
+    {
+        ImageBuffer< SampleStatistics > accumulation( 0, 0 );
+        int                             passCount = 0;
+        if ( !ReadCheckpoint( i_options.m_checkpointPath, i_options.m_renderSettings, accumulation, passCount ) )
+        {
+            return false;
+        }
+
+        if ( accumulation.Width() != image.Width() || accumulation.Height() != image.Height() )
+        {
+            fprintf( stderr,
+                     "The checkpoint '%s' is of a %dx%d image!\n",
+                     i_options.m_checkpointPath.c_str(),
+                     accumulation.Width(),
+                     accumulation.Height() );
+            return false;
+        }
+
+        renderer.ResumeFrom( accumulation, passCount );
+    }
+
+    if ( i_options.m_outputFormat == ImageFileFormat::PPM && !i_options.m_renderSettings.m_progressive )
+    {
+        // Finished scanlines are streamed out to disk while the remaining tiles are rendering.
+        PPMScanlineWriter imageWriter( image );
+        if ( !imageWriter.Open( i_options.m_outputPath ) )
+        {
+            return false;
+        }
+
+        renderer.Render(
+            i_camera, i_scene, image, [ & ]( const gm::Vec2iRange& i_tile ) { imageWriter.CompleteTile( i_tile ); } );
+
+        if ( !imageWriter.Close() )
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // Snapshots are written to a temporary file first, then moved over the output, such that readers never
+        // observe a partially written image.
+        const std::string snapshotPath         = i_options.m_outputPath + ".snapshot";
+        double            lastSnapshotSeconds    = 0.0;
+        bool              snapshotWriteSuccess   = true;
+        double            lastCheckpointSeconds  = 0.0;
+        bool              checkpointWriteSuccess = true;
+        renderer.Render( i_camera, i_scene, image, Renderer::TileFunction(), [ & ]( const RenderPass& i_pass ) {
+            if ( i_options.m_printStatistics )
+            {
+                std::cout << "Pass " << i_pass.m_passIndex << ": " << i_pass.m_samplesPerPixel << " samples per-pixel, "
+                          << std::fixed << std::setprecision( 3 ) << i_pass.m_elapsedSeconds << "s" << std::endl;
+            }
+
+            // The final pass is written out below, once the render returns.
+            if ( !i_pass.m_isFinal && !i_options.m_checkpointPath.empty() && checkpointWriteSuccess &&
+                 i_pass.m_elapsedSeconds - lastCheckpointSeconds >= i_options.m_checkpointIntervalSeconds )
+            {
+                checkpointWriteSuccess = WriteCheckpoint( i_options.m_checkpointPath,
+                                                          i_options.m_renderSettings,
+                                                          renderer.Accumulation(),
+                                                          i_pass.m_passIndex + 1 );
+                lastCheckpointSeconds  = i_pass.m_elapsedSeconds;
+            }
+
+            if ( !i_pass.m_isFinal && i_options.m_snapshotIntervalSeconds >= 0.0 && snapshotWriteSuccess &&
+                 i_pass.m_elapsedSeconds - lastSnapshotSeconds >= i_options.m_snapshotIntervalSeconds )
+            {
+                snapshotWriteSuccess = WriteImageFile( image, snapshotPath, i_options.m_outputFormat ) &&
+                                       std::rename( snapshotPath.c_str(), i_options.m_outputPath.c_str() ) == 0;
+                lastSnapshotSeconds  = i_pass.m_elapsedSeconds;
+            }
+        } );
+
+        if ( !WriteImageFile( image, i_options.m_outputPath, i_options.m_outputFormat ) )
+        {
+            return false;
+        }
+
+        if ( !i_options.m_checkpointPath.empty() &&
+             !WriteCheckpoint( i_options.m_checkpointPath,
+                               i_options.m_renderSettings,
+                               renderer.Accumulation(),
+                               renderer.Statistics().m_passCount ) )
+        {
+            return false;
+        }
+    }
+
+    if ( i_options.m_printStatistics )
+    {
+        PrintRenderStatistics( renderer.Statistics(), i_options.m_imageWidth * i_options.m_imageHeight );
+    }
+
+    if ( !i_options.m_sampleCountOutputPath.empty() )
+    {
+        const AdaptiveSamplingSettings& sampling = i_options.m_renderSettings.m_sampling;
+        RGBImageBuffer                  heatMap( i_options.m_imageWidth, i_options.m_imageHeight );
+        ComputeSampleCountHeatMap(
+            renderer.SampleCounts(), sampling.m_minSamplesPerPixel, sampling.m_maxSamplesPerPixel, heatMap );
+        if ( !WritePPMImage( heatMap, i_options.m_sampleCountOutputPath ) )
+        {
+            return false;
+        }
+    }
+
+    if ( i_options.m_debug )
+    {
+        PathStatistics pathStatistics;
+        renderer.ShadePixel(
+            i_options.m_debugPixelCoord, i_camera, i_scene, image, pathStatistics, /* printDebug */ true );
+    }
+
+    return true;
+}
+
+RAYTRACE_NS_CLOSE
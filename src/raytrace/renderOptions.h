@@ -0,0 +1,116 @@
+#pragma once
+
+/// \file raytrace/renderOptions.h
+///
+/// Command line options shared by the rendering programs, and the render & write out of an image driven by them.
+
+#include <raytrace/camera.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/renderSettings.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/types/vec2i.h>
+
+#include <cxxopts.hpp>
+
+#include <string>
+
+RAYTRACE_NS_OPEN
+
+/// \enum ImageFileFormat
+///
+/// The file format of the output image.
+enum class ImageFileFormat
+{
+    PPM = 0, ///< Binary PPM, with 8-bit gamma-corrected channels.  Scanlines are written while rendering.
+    PFM,     ///< Portable float map, with linear 32-bit float channels.
+    EXR      ///< Uncompressed scanline OpenEXR, with linear 32-bit float channels.
+};
+
+/// Deduce the image file format from the extension of \p i_filePath.
+///
+/// \return The file format.  Unknown extensions are written as \ref ImageFileFormat::PPM.
+ImageFileFormat ImageFileFormatFromPath( const std::string& i_filePath );
+
+/// \class RenderOptions
+///
+/// The values of the command line options added by \ref AddRenderOptions.
+class RenderOptions
+{
+public:
+    /// Width of the image.
+    int m_imageWidth = 384;
+
+    /// Height of the image.
+    int m_imageHeight = 256;
+
+    /// File location to save the image.
+    std::string m_outputPath = "out.ppm";
+
+    /// File format to save the image in, deduced from \ref m_outputPath.
+    ImageFileFormat m_outputFormat = ImageFileFormat::PPM;
+
+    /// With progressive rendering, the minimum seconds between snapshots of the image, written to \ref m_outputPath
+    /// after a pass completes.  Zero writes a snapshot after every pass, and a negative interval writes none.
+    double m_snapshotIntervalSeconds = 0.0;
+
+    /// Optional file location to write checkpoints of the accumulated samples into.
+    std::string m_checkpointPath;
+
+    /// The minimum seconds between checkpoints, written after a pass completes.  A checkpoint is also written once
+    /// the render stops.
+    double m_checkpointIntervalSeconds = 60.0;
+
+    /// Resume from the checkpoint at \ref m_checkpointPath, if it exists.
+    bool m_resume = false;
+
+    /// Optional file location to save a heat map of the number of samples taken per-pixel.
+    std::string m_sampleCountOutputPath;
+
+    /// Print thread, sample & ray counts after rendering.
+    bool m_printStatistics = false;
+
+    /// Print the samples & paths of \ref m_debugPixelCoord after rendering.
+    bool m_debug = false;
+
+    /// The pixel to print debug information for, in image coordinates (where y points up).
+    gm::Vec2i m_debugPixelCoord;
+
+    /// Settings of the renderer.
+    RenderSettings m_renderSettings;
+
+    /// Get the aspect ratio of the image.
+    inline float AspectRatio() const
+    {
+        return ( float ) m_imageWidth / m_imageHeight;
+    }
+};
+
+/// Add the command line options common to all rendering programs into \p io_options.
+///
+/// \param io_options The options to add into.
+void AddRenderOptions( cxxopts::Options& io_options );
+
+/// Extract the values of the options added by \ref AddRenderOptions from the parsed command line \p i_args.
+///
+/// \param i_args The parsed command line arguments.
+/// \param o_options The render options.
+///
+/// \return Whether the option values are valid.  An invalid value is reported to stderr.
+bool ParseRenderOptions( const cxxopts::ParseResult& i_args, RenderOptions& o_options );
+
+/// Render \p i_scene viewed through \p i_camera, and write the image out according to \p i_options.
+///
+/// For PPM output, finished scanlines are written to disk while the remaining tiles are rendering.  Floating-point
+/// formats are written once the render is complete.  Progressive renders write snapshots of the image between
+/// passes, according to \ref RenderOptions::m_snapshotIntervalSeconds, and checkpoints according to
+/// \ref RenderOptions::m_checkpointIntervalSeconds.
+///
+/// \param i_options The render options.
+/// \param i_camera The camera.
+/// \param i_scene The scene to render.
+///
+/// \return success of rendering and writing out the image.
+bool RenderImageFile( const RenderOptions& i_options, const Camera& i_camera, const SceneObject& i_scene );
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,73 @@
+#pragma once
+
+/// \file raytrace/renderSettings.h
+///
+/// Parameters of a render, shared by all the programs driving a \ref Renderer.
+
+#include <raytrace/adaptiveSampling.h>
+#include <raytrace/pathTracer.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/sampler.h>
+#include <raytrace/tileRenderer.h>
+
+#include <cstdint>
+
+RAYTRACE_NS_OPEN
+
+/// \enum ShadingMode
+///
+/// How the color of a camera ray sample is computed.
+enum class ShadingMode
+{
+    PathTrace = 0, ///< Trace a path through the scene, scattering off materials.
+    Normals        ///< Map the surface normal of the nearest hit into a color.  Materials are not required.
+};
+
+/// \class RenderSettings
+///
+/// Parameters controlling how an image is rendered.
+class RenderSettings
+{
+public:
+    /// How each camera ray sample is shaded.
+    ShadingMode m_shadingMode = ShadingMode::PathTrace;
+
+    /// Number of samples taken per-pixel.
+    AdaptiveSamplingSettings m_sampling;
+
+    /// The sequence which the pixel, lens, and scattering samples are drawn from.
+    SamplerType m_sampler = SamplerType::Independent;
+
+    /// Path construction parameters, for \ref ShadingMode::PathTrace.
+    PathTracerSettings m_pathTracer;
+
+    /// Trace the paths of each tile together with a \ref WavefrontPathTracer, rather than one at a time.
+    /// Only applies to \ref ShadingMode::PathTrace.  The image is identical either way.
+    bool m_wavefront = false;
+
+    /// Render in passes of 1, 2, 4, ... samples per-pixel over the whole image, up to the maximum sample count,
+    /// accumulating into the estimate of the previous pass.  The image is identical to that of a single pass.
+    bool m_progressive = false;
+
+    /// With \ref m_progressive, the seconds after which the render stops, keeping the image of the last complete
+    /// pass.  Zero for no limit.
+    double m_timeLimitSeconds = 0.0;
+
+    /// Correct the pixel colors for gamma 2.
+    bool m_gammaCorrection = true;
+
+    /// Write the mean sample color of each pixel as is, without gamma correction or clamping, for output into a
+    /// floating-point image format.  Takes precedence over \ref m_gammaCorrection.
+    bool m_linearOutput = false;
+
+    /// Seed for the per-pixel random number generators.
+    uint32_t m_seed = 0;
+
+    /// Number of worker threads.  See \ref ResolveThreadCount.
+    int m_threadCount = 0;
+
+    /// Width and height of the tiles distributed across worker threads.
+    int m_tileSize = c_defaultTileSize;
+};
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,461 @@
+/// \file raytrace/renderer.cpp
+
+#include <raytrace/renderer.h>
+
+#include <raytrace/adaptiveSampling.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/randomNumberGenerator.h>
+#include <raytrace/ray.h>
+#include <raytrace/tileRenderer.h>
+
+#include <gm/functions/clamp.h>
+#include <gm/functions/linearMap.h>
+#include <gm/functions/normalize.h>
+#include <gm/types/floatRange.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <mutex>
+
+RAYTRACE_NS_OPEN
+
+/// \var c_normalizedRange
+///
+/// Normalized float range between 0 and 1.
+static constexpr gm::FloatRange c_normalizedRange( 0.0f, 1.0f );
+
+/// Compute the color of the surface normal of the nearest intersection of \p i_ray.
+///
+/// In the case where there is no intersection, a background color is interpolated from a top-down gradient.
+///
+/// \param i_ray The ray.
+/// \param i_scene The scene to test for ray intersection.
+///
+/// \return The computed ray color.
+static gm::Vec3f ComputeNormalColor( const Ray& i_ray, const SceneObject& i_scene )
+{
+    HitRecord record;
+    if ( i_scene.Hit( i_ray, gm::FloatRange( 0, std::numeric_limits< float >::max() ), record ) )
+    {
+        const gm::FloatRange normalRange( -1.0, 1.0 );
+        return gm::LinearMap( record.m_normal, normalRange, c_normalizedRange );
+    }
+
+    return ComputeBackgroundColor( i_ray );
+}
+
+/// Convert the mean sample color \p i_meanColor of a pixel into its output color.
+///
+/// \param i_meanColor The mean color of the pixel samples.
+/// \param i_settings The render settings.
+///
+/// \return The pixel color, clamped to [0,1], or the linear mean color as is with
+/// \ref RenderSettings::m_linearOutput.
+static gm::Vec3f ComputePixelColor( const gm::Vec3f& i_meanColor, const RenderSettings& i_settings )
+{
+    if ( i_settings.m_linearOutput )
+    {
+        return i_meanColor;
+    }
+
+    gm::Vec3f pixelColor = i_meanColor;
+    if ( i_settings.m_gammaCorrection )
+    {
+        // Correct for gamma 2, by raising to 1/gamma.
+        pixelColor[ 0 ] = std::sqrt( pixelColor[ 0 ] );
+        pixelColor[ 1 ] = std::sqrt( pixelColor[ 1 ] );
+        pixelColor[ 2 ] = std::sqrt( pixelColor[ 2 ] );
+    }
+
+    // Clamp the value down to [0,1).
+    return gm::Clamp( pixelColor, c_normalizedRange );
+}
+
+Renderer::Renderer( const RenderSettings& i_settings )
+    : m_settings( i_settings )
+    , m_sampleCounts( 0, 0 )
+    , m_accumulation( 0, 0 )
+{
+}
+
+void Renderer::Render( const Camera&       i_camera,
+                       const SceneObject&  i_scene,
+                       RGBImageBuffer&     o_image,
+                       const TileFunction& i_tileFunction,
+                       const PassFunction& i_passFunction )
+{
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point renderBegin = Clock::now();
+
+    const gm::Vec2i imageSize( o_image.Width(), o_image.Height() );
+    m_sampleCounts.Resize( imageSize.X(), imageSize.Y() );
+    m_statistics = RenderStatistics();
+
+    // Independent sampling draws from the random number generators alone.
+    const Sampler  sampler(
+        m_settings.m_sampler, imageSize.X(), m_settings.m_sampling.m_maxSamplesPerPixel, m_settings.m_seed );
+    const Sampler* activeSampler = m_settings.m_sampler != SamplerType::Independent ? &sampler : nullptr;
+
+    const bool resume = m_resumePassCount > 0 && m_accumulation.Width() == o_image.Width() &&
+                        m_accumulation.Height() == o_image.Height();
+    if ( resume )
+    {
+        // Continue from the samples of the passes completed by the interrupted render.
+        m_statistics.m_passCount = m_resumePassCount;
+        for ( const gm::Vec2i& pixelCoord : o_image.Extent() )
+        {
+            _ResolvePixel( pixelCoord, o_image );
+        }
+    }
+    else
+    {
+        m_accumulation.Resize( o_image.Width(), o_image.Height() );
+        m_accumulation.Clear();
+    }
+    m_resumePassCount = 0;
+
+    // Only a progressive render can be stopped early, with the image of the last complete pass.
+    const bool              timeLimited = m_settings.m_progressive && m_settings.m_timeLimitSeconds > 0.0;
+    const Clock::time_point deadline =
+        timeLimited ? renderBegin + std::chrono::duration_cast< Clock::duration >(
+                                        std::chrono::duration< double >( m_settings.m_timeLimitSeconds ) )
+                    : Clock::time_point::max();
+
+    WorkStealingScheduler scheduler( ResolveThreadCount( m_settings.m_threadCount ) );
+    m_statistics.m_workers.resize( scheduler.ThreadCount() );
+
+    const int                       maxSamplesPerPixel = m_settings.m_sampling.m_maxSamplesPerPixel;
+    ImageBuffer< SampleStatistics > passBeginAccumulation( 0, 0 );
+    for ( int passIndex = m_statistics.m_passCount;; ++passIndex )
+    {
+        // Each progressive pass doubles the number of samples per-pixel.
+        const int64_t passSampleCount = int64_t( 1 ) << std::min( passIndex, 31 );
+        const int     sampleTarget =
+            m_settings.m_progressive ? static_cast< int >( std::min< int64_t >( passSampleCount, maxSamplesPerPixel ) )
+                                     : maxSamplesPerPixel;
+        if ( timeLimited )
+        {
+            // Keep the samples of the last complete pass, to restore should this pass be cancelled.
+            passBeginAccumulation = m_accumulation;
+        }
+
+        // The pass is specialized for the lens model, such that pinhole cameras skip lens sampling.
+        const bool complete = DispatchLensModel( i_camera, imageSize, [ & ]( const auto& i_rayGenerator ) {
+            return _RenderPass(
+                sampleTarget, deadline, i_rayGenerator, activeSampler, i_scene, o_image, scheduler, i_tileFunction );
+        } );
+        for ( size_t workerIndex = 0; workerIndex < m_statistics.m_workers.size(); ++workerIndex )
+        {
+            m_statistics.m_workers[ workerIndex ] += scheduler.Statistics()[ workerIndex ];
+        }
+
+        if ( !complete )
+        {
+            m_accumulation = passBeginAccumulation;
+            for ( const gm::Vec2i& pixelCoord : o_image.Extent() )
+            {
+                _ResolvePixel( pixelCoord, o_image );
+            }
+
+            m_statistics.m_timeLimitReached = true;
+            break;
+        }
+
+        m_statistics.m_passCount++;
+
+        RenderPass pass;
+        pass.m_passIndex       = passIndex;
+        pass.m_samplesPerPixel = sampleTarget;
+        pass.m_elapsedSeconds  = std::chrono::duration< double >( Clock::now() - renderBegin ).count();
+        pass.m_isFinal         = sampleTarget >= maxSamplesPerPixel;
+        if ( i_passFunction )
+        {
+            i_passFunction( pass );
+        }
+
+        if ( pass.m_isFinal )
+        {
+            break;
+        }
+    }
+
+    for ( const gm::Vec2i& pixelCoord : o_image.Extent() )
+    {
+        m_statistics.m_sampleCount += m_sampleCounts( pixelCoord.X(), pixelCoord.Y() );
+    }
+}
+
+void Renderer::ResumeFrom( const ImageBuffer< SampleStatistics >& i_accumulation, int i_passCount )
+{
+    m_accumulation    = i_accumulation;
+    m_resumePassCount = i_passCount;
+}
+
+int Renderer::ShadePixel( const gm::Vec2i&   i_pixelCoord,
+                          const Camera&      i_camera,
+                          const SceneObject& i_scene,
+                          RGBImageBuffer&    o_image,
+                          PathStatistics&    io_pathStatistics,
+                          bool               i_printDebug ) const
+{
+    if ( i_printDebug )
+    {
+        std::cout << "Pixel " << i_pixelCoord << std::endl;
+    }
+
+    const gm::Vec2i  imageSize( o_image.Width(), o_image.Height() );
+    SampleStatistics sampleStatistics;
+    const Sampler  sampler(
+        m_settings.m_sampler, imageSize.X(), m_settings.m_sampling.m_maxSamplesPerPixel, m_settings.m_seed );
+    const Sampler* activeSampler = m_settings.m_sampler != SamplerType::Independent ? &sampler : nullptr;
+    DispatchLensModel( i_camera, imageSize, [ & ]( const auto& i_rayGenerator ) {
+        _SamplePixel( i_pixelCoord,
+                      imageSize,
+                      m_settings.m_sampling.m_maxSamplesPerPixel,
+                      i_rayGenerator,
+                      activeSampler,
+                      i_scene,
+                      sampleStatistics,
+                      io_pathStatistics,
+                      i_printDebug );
+    } );
+
+    // Assign the finalized, average color of the samples.
+    o_image( i_pixelCoord.X(), i_pixelCoord.Y() ) = ComputePixelColor( sampleStatistics.Mean(), m_settings );
+
+    return sampleStatistics.Count();
+}
+
+template < typename LensT >
+bool Renderer::_RenderPass( int                                          i_sampleTarget,
+                            const std::chrono::steady_clock::time_point& i_deadline,
+                            const CameraRayGenerator< LensT >&           i_rayGenerator,
+                            const Sampler*                               i_sampler,
+                            const SceneObject&                           i_scene,
+                            RGBImageBuffer&                              o_image,
+                            WorkStealingScheduler&                       io_scheduler,
+                            const TileFunction&                          i_tileFunction )
+{
+    using Clock = std::chrono::steady_clock;
+
+    const gm::Vec2i imageSize( o_image.Width(), o_image.Height() );
+    const bool      wavefront = m_settings.m_wavefront && m_settings.m_shadingMode == ShadingMode::PathTrace;
+
+    // Total number of paths & rays traced.
+    std::atomic< size_t > pathCount( 0 );
+    std::atomic< size_t > rayCount( 0 );
+    std::mutex            statisticsMutex;
+
+    // Each pixel is written by exactly one thread.
+    const bool complete =
+        RenderTiles( o_image.Extent(), m_settings.m_tileSize, io_scheduler, [ & ]( const gm::Vec2iRange& i_tile ) {
+            bool tileComplete = true;
+            if ( wavefront )
+            {
+                // The tile is traced as a batch of paths.
+                if ( Clock::now() >= i_deadline )
+                {
+                    return false;
+                }
+
+                WavefrontStatistics tileStatistics;
+                pathCount += _SampleTileWavefront(
+                    i_tile, imageSize, i_sampleTarget, i_rayGenerator, i_sampler, i_scene, tileStatistics );
+                rayCount += tileStatistics.m_intersectionCount;
+                {
+                    std::lock_guard< std::mutex > lock( statisticsMutex );
+                    m_statistics.m_wavefront += tileStatistics;
+                }
+
+                for ( const gm::Vec2i& pixelCoord : i_tile )
+                {
+                    _ResolvePixel( pixelCoord, o_image );
+                }
+            }
+            else
+            {
+                PathStatistics pathStatistics;
+                for ( const gm::Vec2i& pixelCoord : i_tile )
+                {
+                    if ( Clock::now() >= i_deadline )
+                    {
+                        tileComplete = false;
+                        break;
+                    }
+
+                    SampleStatistics& statistics = m_accumulation( pixelCoord.X(), pixelCoord.Y() );
+                    _SamplePixel( pixelCoord,
+                                  imageSize,
+                                  i_sampleTarget,
+                                  i_rayGenerator,
+                                  i_sampler,
+                                  i_scene,
+                                  statistics,
+                                  pathStatistics,
+                                  /* printDebug */ false );
+                    _ResolvePixel( pixelCoord, o_image );
+                }
+
+                pathCount += pathStatistics.m_pathCount;
+                rayCount += pathStatistics.m_rayCount;
+            }
+
+            if ( i_tileFunction && tileComplete )
+            {
+                i_tileFunction( i_tile );
+            }
+
+            return tileComplete;
+        } );
+
+    m_statistics.m_paths.m_pathCount += pathCount;
+    m_statistics.m_paths.m_rayCount += rayCount;
+
+    return complete;
+}
+
+template < typename LensT >
+void Renderer::_SamplePixel( const gm::Vec2i&                   i_pixelCoord,
+                             const gm::Vec2i&                   i_imageSize,
+                             int                                i_sampleTarget,
+                             const CameraRayGenerator< LensT >& i_rayGenerator,
+                             const Sampler*                     i_sampler,
+                             const SceneObject&                 i_scene,
+                             SampleStatistics&                  io_statistics,
+                             PathStatistics&                    io_pathStatistics,
+                             bool                               i_printDebug ) const
+{
+    // Accumulate pixel color over multiple samples, until the target is met or the estimate has converged.
+    for ( int sampleIndex = io_statistics.Count();
+          sampleIndex < i_sampleTarget && !io_statistics.IsComplete( m_settings.m_sampling );
+          ++sampleIndex )
+    {
+        // Random numbers are keyed by pixel & sample, thus independent of the thread & order of evaluation.
+        RandomNumberGenerator rng(
+            i_pixelCoord.Y() * i_imageSize.X() + i_pixelCoord.X(), sampleIndex, m_settings.m_seed, i_sampler );
+        Ray ray = i_rayGenerator.GenerateRay( i_pixelCoord, rng );
+        if ( i_printDebug )
+        {
+            std::cout << c_indent << "Sample: " << sampleIndex << std::endl;
+        }
+
+        gm::Vec3f sampleColor =
+            m_settings.m_shadingMode == ShadingMode::Normals
+                ? ComputeNormalColor( ray, i_scene )
+                : TracePath( ray, i_scene, m_settings.m_pathTracer, rng, &io_pathStatistics, i_printDebug );
+        io_statistics.Add( sampleColor );
+        if ( i_printDebug )
+        {
+            std::cout << c_indent << "Sample color: " << sampleColor << std::endl;
+        }
+    }
+}
+
+template < typename LensT >
+size_t Renderer::_SampleTileWavefront( const gm::Vec2iRange&              i_tile,
+                                       const gm::Vec2i&                   i_imageSize,
+                                       int                                i_sampleTarget,
+                                       const CameraRayGenerator< LensT >& i_rayGenerator,
+                                       const Sampler*                     i_sampler,
+                                       const SceneObject&                 i_scene,
+                                       WavefrontStatistics&               io_statistics )
+{
+    const AdaptiveSamplingSettings& sampling = m_settings.m_sampling;
+    WavefrontPathTracer             pathTracer( m_settings.m_pathTracer );
+
+    std::vector< gm::Vec2i > pixelCoords;
+    for ( const gm::Vec2i& pixelCoord : i_tile )
+    {
+        pixelCoords.push_back( pixelCoord );
+    }
+
+    std::vector< WavefrontPath > paths;
+    std::vector< size_t >        pathPixels;
+    std::vector< gm::Vec2i >     pathPixelCoords;
+    std::vector< gm::Vec2f >     sampleOffsets;
+    std::vector< gm::Vec2f >     lensSamples;
+    std::vector< Ray >           cameraRays;
+
+    // Every pixel takes at least this many samples before convergence is tested, thus they are all traced in the
+    // first round.  Each following round traces a single sample per unconverged pixel.
+    const int initialSampleCount =
+        std::max( std::min( sampling.m_maxSamplesPerPixel, std::max( sampling.m_minSamplesPerPixel, 2 ) ), 1 );
+    size_t sampleCount = 0;
+    while ( true )
+    {
+        paths.clear();
+        pathPixels.clear();
+        pathPixelCoords.clear();
+        sampleOffsets.clear();
+        lensSamples.clear();
+        for ( size_t pixelIndex = 0; pixelIndex < pixelCoords.size(); ++pixelIndex )
+        {
+            const gm::Vec2i&        pixelCoord = pixelCoords[ pixelIndex ];
+            const SampleStatistics& statistics = m_accumulation( pixelCoord.X(), pixelCoord.Y() );
+            if ( statistics.Count() >= i_sampleTarget || statistics.IsComplete( sampling ) )
+            {
+                continue;
+            }
+
+            const int roundSampleEnd = statistics.Count() < initialSampleCount
+                                           ? std::min( initialSampleCount, i_sampleTarget )
+                                           : statistics.Count() + 1;
+            for ( int sampleIndex = statistics.Count(); sampleIndex < roundSampleEnd; ++sampleIndex )
+            {
+                // Random numbers are keyed by pixel & sample, matching ShadePixel.
+                RandomNumberGenerator rng(
+                    pixelCoord.Y() * i_imageSize.X() + pixelCoord.X(), sampleIndex, m_settings.m_seed, i_sampler );
+                gm::Vec2f sampleOffset;
+                gm::Vec2f lensSample;
+                CameraRayGenerator< LensT >::DrawSamples( rng, sampleOffset, lensSample );
+                paths.emplace_back( Ray(), rng );
+                pathPixels.push_back( pixelIndex );
+                pathPixelCoords.push_back( pixelCoord );
+                sampleOffsets.push_back( sampleOffset );
+                lensSamples.push_back( lensSample );
+            }
+        }
+
+        if ( paths.empty() )
+        {
+            break;
+        }
+
+        // The lens samples & camera rays of the round are mapped & generated as single batches, from the samples
+        // drawn above.
+        CameraRayGenerator< LensT >::MapLensSamples( lensSamples.data(), lensSamples.size() );
+        cameraRays.resize( paths.size() );
+        i_rayGenerator.GenerateRays(
+            pathPixelCoords.data(), sampleOffsets.data(), lensSamples.data(), paths.size(), cameraRays.data() );
+        for ( size_t pathIndex = 0; pathIndex < paths.size(); ++pathIndex )
+        {
+            paths[ pathIndex ].m_ray = cameraRays[ pathIndex ];
+        }
+
+        pathTracer.Trace( i_scene, paths, io_statistics );
+
+        // Samples of each pixel were queued in order, thus are accumulated in the same order as ShadePixel.
+        for ( size_t pathIndex = 0; pathIndex < paths.size(); ++pathIndex )
+        {
+            const gm::Vec2i& pixelCoord = pixelCoords[ pathPixels[ pathIndex ] ];
+            m_accumulation( pixelCoord.X(), pixelCoord.Y() ).Add( paths[ pathIndex ].m_color );
+        }
+        sampleCount += paths.size();
+    }
+
+    return sampleCount;
+}
+
+void Renderer::_ResolvePixel( const gm::Vec2i& i_pixelCoord, RGBImageBuffer& o_image )
+{
+    const SampleStatistics& statistics = m_accumulation( i_pixelCoord.X(), i_pixelCoord.Y() );
+    o_image( i_pixelCoord.X(), i_pixelCoord.Y() )        = ComputePixelColor( statistics.Mean(), m_settings );
+    m_sampleCounts( i_pixelCoord.X(), i_pixelCoord.Y() ) = statistics.Count();
+}
+
+RAYTRACE_NS_CLOSE
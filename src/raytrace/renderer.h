@@ -0,0 +1,211 @@
+#pragma once
+
+/// \file raytrace/renderer.h
+///
+/// Multi-threaded renderer of a camera view of a scene into an image.
+
+#include <raytrace/adaptiveSampling.h>
+#include <raytrace/camera.h>
+#include <raytrace/cameraRayGenerator.h>
+#include <raytrace/imageBuffer.h>
+#include <raytrace/pathTracer.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/renderSettings.h>
+#include <raytrace/sceneObject.h>
+#include <raytrace/wavefrontPathTracer.h>
+#include <raytrace/workStealingScheduler.h>
+
+#include <gm/types/vec2i.h>
+#include <gm/types/vec2iRange.h>
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class RenderStatistics
+///
+/// Counters accumulated over a single \ref Renderer::Render.
+class RenderStatistics
+{
+public:
+    /// Time and task accounting, per worker thread, summed over the passes.
+    std::vector< WorkerStatistics > m_workers;
+
+    /// Number of complete sample passes, including those of a resumed render.
+    int m_passCount = 0;
+
+    /// Whether the render was stopped by \ref RenderSettings::m_timeLimitSeconds.
+    bool m_timeLimitReached = false;
+
+    /// Number of camera ray samples taken, across all pixels.
+    size_t m_sampleCount = 0;
+
+    /// Paths & rays traced, across all pixels.
+    PathStatistics m_paths;
+
+    /// Per-stage accounting, summed over the worker threads, of a render with \ref RenderSettings::m_wavefront.
+    WavefrontStatistics m_wavefront;
+};
+
+/// \class RenderPass
+///
+/// Progress of a render, reported once each sample pass is complete.
+class RenderPass
+{
+public:
+    /// Index of the pass, starting from 0.
+    int m_passIndex = 0;
+
+    /// The number of samples per-pixel taken once this pass is complete.  With adaptive sampling, converged pixels
+    /// take fewer.
+    int m_samplesPerPixel = 0;
+
+    /// Seconds since the render started.
+    double m_elapsedSeconds = 0.0;
+
+    /// Whether every pixel has taken all of its samples, such that no pass follows.
+    bool m_isFinal = false;
+};
+
+/// \class Renderer
+///
+/// Renders images of a scene, according to \ref RenderSettings.
+///
+/// Pixels are distributed across worker threads in tiles.  The random numbers of each pixel sample are keyed
+/// by pixel & sample index, thus renders with the same settings are identical regardless of the thread count.
+///
+/// The samples of each pixel are accumulated into a buffer of \ref SampleStatistics, over one or more passes (see
+/// \ref RenderSettings::m_progressive).  Each pass takes the samples of a pixel in order, thus the image does not
+/// depend on the number of passes.
+class Renderer final
+{
+public:
+    /// \typedef TileFunction
+    ///
+    /// Called once all the pixels of a tile are final.  It may be invoked concurrently from worker threads.
+    using TileFunction = std::function< void( const gm::Vec2iRange& ) >;
+
+    /// \typedef PassFunction
+    ///
+    /// Called from the rendering thread once every pixel of the image holds the estimate of a complete pass.
+    using PassFunction = std::function< void( const RenderPass& ) >;
+
+    /// Construct a renderer.
+    ///
+    /// \param i_settings The render settings.
+    explicit Renderer( const RenderSettings& i_settings );
+
+    /// Get the render settings.
+    inline const RenderSettings& Settings() const
+    {
+        return m_settings;
+    }
+
+    /// Render the view of \p i_camera of \p i_scene into every pixel of \p o_image.
+    ///
+    /// \param i_camera The camera.
+    /// \param i_scene The scene to render.
+    /// \param o_image The image to render into.  Its dimensions determine the resolution of the render.
+    /// \param i_tileFunction Optional function to invoke per-tile, after its pixels are final for the current pass.
+    /// This allows consuming finished regions of the image while the render is still running.
+    /// \param i_passFunction Optional function to invoke after each complete pass.
+    void Render( const Camera&       i_camera,
+                 const SceneObject&  i_scene,
+                 RGBImageBuffer&     o_image,
+                 const TileFunction& i_tileFunction = TileFunction(),
+                 const PassFunction& i_passFunction = PassFunction() );
+
+    /// Shade a single pixel, by averaging the colors of camera ray samples through it.
+    ///
+    /// \param i_pixelCoord The coordinate of the pixel.
+    /// \param i_camera The camera.
+    /// \param i_scene The scene to render.
+    /// \param o_image The image to write the pixel color into.
+    /// \param io_pathStatistics Counters to accumulate into.
+    /// \param i_printDebug Print the samples and their paths to stdout.
+    ///
+    /// \return The number of samples taken.
+    int ShadePixel( const gm::Vec2i&   i_pixelCoord,
+                    const Camera&      i_camera,
+                    const SceneObject& i_scene,
+                    RGBImageBuffer&    o_image,
+                    PathStatistics&    io_pathStatistics,
+                    bool               i_printDebug = false ) const;
+
+    /// Get the counters of the last render.
+    inline const RenderStatistics& Statistics() const
+    {
+        return m_statistics;
+    }
+
+    /// Get the number of samples taken per-pixel, in the last render.
+    inline const ImageBuffer< int >& SampleCounts() const
+    {
+        return m_sampleCounts;
+    }
+
+    /// Get the samples accumulated per-pixel.  Within a \ref PassFunction, and once a render has returned, these are
+    /// the samples of the complete passes.
+    inline const ImageBuffer< SampleStatistics >& Accumulation() const
+    {
+        return m_accumulation;
+    }
+
+    /// Continue the next \ref Render from the samples \p i_accumulation of an interrupted render with the same
+    /// settings, which completed \p i_passCount passes.  The image is identical to that of an uninterrupted render.
+    ///
+    /// \param i_accumulation The samples accumulated per-pixel.  Ignored if the dimensions do not match those of the
+    /// next render.
+    /// \param i_passCount The number of complete passes.
+    void ResumeFrom( const ImageBuffer< SampleStatistics >& i_accumulation, int i_passCount );
+
+private:
+    // Render the pass of \p i_sampleTarget samples per-pixel.  Returns false if the pass was cancelled by
+    // \p i_deadline, leaving some pixels short of the target.
+    template < typename LensT >
+    bool _RenderPass( int                                          i_sampleTarget,
+                      const std::chrono::steady_clock::time_point& i_deadline,
+                      const CameraRayGenerator< LensT >&           i_rayGenerator,
+                      const Sampler*                               i_sampler,
+                      const SceneObject&                           i_scene,
+                      RGBImageBuffer&                              o_image,
+                      WorkStealingScheduler&                       io_scheduler,
+                      const TileFunction&                          i_tileFunction );
+
+    // Take the samples of the pixel at \p i_pixelCoord, until \p io_statistics holds \p i_sampleTarget samples or
+    // has converged.
+    template < typename LensT >
+    void _SamplePixel( const gm::Vec2i&                   i_pixelCoord,
+                       const gm::Vec2i&                   i_imageSize,
+                       int                                i_sampleTarget,
+                       const CameraRayGenerator< LensT >& i_rayGenerator,
+                       const Sampler*                     i_sampler,
+                       const SceneObject&                 i_scene,
+                       SampleStatistics&                  io_statistics,
+                       PathStatistics&                    io_pathStatistics,
+                       bool                               i_printDebug ) const;
+
+    // Sample all the pixels of \p i_tile up to \p i_sampleTarget with a \ref WavefrontPathTracer.  Returns the
+    // number of samples taken.
+    template < typename LensT >
+    size_t _SampleTileWavefront( const gm::Vec2iRange&              i_tile,
+                                 const gm::Vec2i&                   i_imageSize,
+                                 int                                i_sampleTarget,
+                                 const CameraRayGenerator< LensT >& i_rayGenerator,
+                                 const Sampler*                     i_sampler,
+                                 const SceneObject&                 i_scene,
+                                 WavefrontStatistics&               io_statistics );
+
+    // Write the pixel color & sample count of \p i_pixelCoord from the accumulated samples.
+    void _ResolvePixel( const gm::Vec2i& i_pixelCoord, RGBImageBuffer& o_image );
+
+    RenderSettings                  m_settings;
+    RenderStatistics                m_statistics;
+    ImageBuffer< int >              m_sampleCounts;
+    ImageBuffer< SampleStatistics > m_accumulation;
+    int                             m_resumePassCount = 0;
+};
+
+RAYTRACE_NS_CLOSE
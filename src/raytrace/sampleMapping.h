@@ -0,0 +1,359 @@
+#pragma once
+
+/// \file raytrace/sampleMapping.h
+///
+/// Mappings of uniform samples in [0,1)^2 onto the unit disk, hemisphere & sphere, without calls into libm.
+///
+/// The sine & cosine are approximated by polynomials over [-pi/4,pi/4], accurate to within a float ulp or two,
+/// such that the mapped distributions are uniform for all practical purposes.
+///
+/// The batch kernels map an array of samples, 4 at a time using SSE2 where supported by the CPU.  Every kernel
+/// performs the same floating point operations in the same order, thus the batch & scalar results are identical.
+
+#include <raytrace/cpuFeatures.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/base/constants.h>
+#include <gm/types/vec2f.h>
+#include <gm/types/vec3f.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined( RAYTRACE_X86 )
+#include <immintrin.h>
+#endif
+
+RAYTRACE_NS_OPEN
+
+static_assert( sizeof( gm::Vec2f ) == 2 * sizeof( float ), "gm::Vec2f is expected to be tightly packed." );
+
+/// \cond PRIVATE
+// Taylor series coefficients of the sine & cosine, which are accurate to float precision over [-pi/4,pi/4].
+constexpr float _c_sinCoefficient3 = -1.0f / 6.0f;
+constexpr float _c_sinCoefficient5 = 1.0f / 120.0f;
+constexpr float _c_sinCoefficient7 = -1.0f / 5040.0f;
+constexpr float _c_sinCoefficient9 = 1.0f / 362880.0f;
+constexpr float _c_cosCoefficient2 = -1.0f / 2.0f;
+constexpr float _c_cosCoefficient4 = 1.0f / 24.0f;
+constexpr float _c_cosCoefficient6 = -1.0f / 720.0f;
+constexpr float _c_cosCoefficient8 = 1.0f / 40320.0f;
+/// \endcond
+
+/// Compute the sine & cosine of the angle \p i_angle, by polynomial approximation.
+///
+/// \param i_angle The angle in radians, within [-pi/4,pi/4].
+/// \param o_sine The sine of the angle.
+/// \param o_cosine The cosine of the angle.
+inline void SinCosQuarterPi( float i_angle, float& o_sine, float& o_cosine )
+{
+    const float angleSquared = i_angle * i_angle;
+
+    o_sine = _c_sinCoefficient9;
+    o_sine = o_sine * angleSquared + _c_sinCoefficient7;
+    o_sine = o_sine * angleSquared + _c_sinCoefficient5;
+    o_sine = o_sine * angleSquared + _c_sinCoefficient3;
+    o_sine = ( o_sine * angleSquared ) * i_angle + i_angle;
+
+    o_cosine = _c_cosCoefficient8;
+    o_cosine = o_cosine * angleSquared + _c_cosCoefficient6;
+    o_cosine = o_cosine * angleSquared + _c_cosCoefficient4;
+    o_cosine = o_cosine * angleSquared + _c_cosCoefficient2;
+    o_cosine = o_cosine * angleSquared + 1.0f;
+}
+
+/// Compute the sine & cosine of the angle \p i_turns, in turns (whole revolutions), by polynomial approximation.
+///
+/// The angle is reduced to the nearest quarter turn, and the remainder within [-1/8,1/8] turns is evaluated by
+/// \ref SinCosQuarterPi.
+///
+/// \param i_turns The non-negative angle in turns, such that 1 is equivalent to 2 pi radians.
+/// \param o_sine The sine of the angle.
+/// \param o_cosine The cosine of the angle.
+inline void SinCosTurns( float i_turns, float& o_sine, float& o_cosine )
+{
+    const float quarterTurns = i_turns * 4.0f;
+    const int   quadrant     = static_cast< int >( quarterTurns + 0.5f );
+    const float remainder    = quarterTurns - static_cast< float >( quadrant );
+
+    float sine;
+    float cosine;
+    SinCosQuarterPi( remainder * gm::HalfPi, sine, cosine );
+
+    // Rotate by the quadrant.
+    const bool swap = ( quadrant & 1 ) != 0;
+    o_sine          = swap ? cosine : sine;
+    o_cosine        = swap ? sine : cosine;
+    o_sine          = ( quadrant & 2 ) != 0 ? -o_sine : o_sine;
+    o_cosine        = ( ( quadrant + 1 ) & 2 ) != 0 ? -o_cosine : o_cosine;
+}
+
+/// Map the uniform sample \p i_sample onto the unit disk, with the concentric mapping of Shirley & Chiu, "A Low
+/// Distortion Map Between Disk and Square".
+///
+/// Concentric squares are mapped onto concentric circles, thus the mapping is uniform by area, and preserves the
+/// stratification of the sample.
+///
+/// \param i_sample The uniform sample, in [0,1) along each axis.
+///
+/// \return The point in the unit disk.
+inline gm::Vec2f ConcentricDiskSample( const gm::Vec2f& i_sample )
+{
+    const float a = i_sample.X() * 2.0f - 1.0f;
+    const float b = i_sample.Y() * 2.0f - 1.0f;
+
+    // The larger coordinate is the radius, and the ratio of the smaller to the larger is the angle within the
+    // octant, in eighths of a turn.
+    const bool  major  = std::abs( a ) > std::abs( b );
+    const float radius = major ? a : b;
+    const float ratio  = ( major ? b : a ) / ( radius != 0.0f ? radius : 1.0f );
+
+    float sine;
+    float cosine;
+    SinCosQuarterPi( ratio * ( gm::Pi * 0.25f ), sine, cosine );
+    return major ? gm::Vec2f( radius * cosine, radius * sine ) : gm::Vec2f( radius * sine, radius * cosine );
+}
+
+/// Map the uniform sample \p i_sample onto the unit sphere.
+///
+/// By Archimedes' hat-box theorem, the height of a uniformly distributed point on the sphere is itself uniformly
+/// distributed, thus the height and the angle around the Z axis are sampled independently.
+///
+/// \param i_sample The uniform sample, in [0,1) along each axis.  X is the angle around the Z axis, Y the height.
+///
+/// \return The unit vector.
+inline gm::Vec3f UniformSphereSample( const gm::Vec2f& i_sample )
+{
+    const float z      = i_sample.Y() * 2.0f - 1.0f;
+    const float radius = std::sqrt( std::max( 0.0f, 1.0f - z * z ) );
+
+    float sine;
+    float cosine;
+    SinCosTurns( i_sample.X(), sine, cosine );
+    return gm::Vec3f( radius * cosine, radius * sine, z );
+}
+
+/// Map the uniform sample \p i_sample onto the unit hemisphere about the Z axis, distributed by the cosine of the
+/// angle to the Z axis.
+///
+/// By Malley's method, a point uniformly distributed on the unit disk is projected up onto the hemisphere.
+///
+/// \param i_sample The uniform sample, in [0,1) along each axis.
+///
+/// \return The unit vector, whose Z coordinate is non-negative.
+inline gm::Vec3f CosineHemisphereSample( const gm::Vec2f& i_sample )
+{
+    const gm::Vec2f point = ConcentricDiskSample( i_sample );
+    const float     z     = std::sqrt( std::max( 0.0f, 1.0f - point.X() * point.X() - point.Y() * point.Y() ) );
+    return gm::Vec3f( point.X(), point.Y(), z );
+}
+
+/// Map the \p i_count uniform samples \p i_samples onto the unit disk, one sample at a time.
+///
+/// \param i_samples The uniform samples.
+/// \param i_count The number of samples.
+/// \param o_points The points in the unit disk, one per sample.
+///
+/// \sa ConcentricDiskSample
+inline void ConcentricDiskSamplesScalar( const gm::Vec2f* i_samples, size_t i_count, gm::Vec2f* o_points )
+{
+    for ( size_t sampleIndex = 0; sampleIndex < i_count; ++sampleIndex )
+    {
+        o_points[ sampleIndex ] = ConcentricDiskSample( i_samples[ sampleIndex ] );
+    }
+}
+
+/// Map the \p i_count uniform samples \p i_samples onto the unit sphere, one sample at a time.
+///
+/// \param i_samples The uniform samples.
+/// \param i_count The number of samples.
+/// \param o_directions The unit vectors, one per sample.
+///
+/// \sa UniformSphereSample
+inline void UniformSphereSamplesScalar( const gm::Vec2f* i_samples, size_t i_count, gm::Vec3f* o_directions )
+{
+    for ( size_t sampleIndex = 0; sampleIndex < i_count; ++sampleIndex )
+    {
+        o_directions[ sampleIndex ] = UniformSphereSample( i_samples[ sampleIndex ] );
+    }
+}
+
+#if defined( RAYTRACE_X86 )
+
+/// \cond PRIVATE
+// Bitwise select: ( mask & a ) | ( ~mask & b ).
+inline __m128 _SelectSSE2( __m128 i_mask, __m128 i_a, __m128 i_b )
+{
+    return _mm_or_ps( _mm_and_ps( i_mask, i_a ), _mm_andnot_ps( i_mask, i_b ) );
+}
+
+// Load 4 consecutive samples, de-interleaving their X & Y coordinates.
+inline void _LoadSamplesSSE2( const gm::Vec2f* i_samples, __m128& o_x, __m128& o_y )
+{
+    const __m128 low  = _mm_loadu_ps( &i_samples[ 0 ].X() );
+    const __m128 high = _mm_loadu_ps( &i_samples[ 2 ].X() );
+    o_x               = _mm_shuffle_ps( low, high, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+    o_y               = _mm_shuffle_ps( low, high, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+}
+
+// Vector form of \ref SinCosQuarterPi.
+inline void _SinCosQuarterPiSSE2( __m128 i_angle, __m128& o_sine, __m128& o_cosine )
+{
+    const __m128 angleSquared = _mm_mul_ps( i_angle, i_angle );
+
+    o_sine = _mm_set1_ps( _c_sinCoefficient9 );
+    o_sine = _mm_add_ps( _mm_mul_ps( o_sine, angleSquared ), _mm_set1_ps( _c_sinCoefficient7 ) );
+    o_sine = _mm_add_ps( _mm_mul_ps( o_sine, angleSquared ), _mm_set1_ps( _c_sinCoefficient5 ) );
+    o_sine = _mm_add_ps( _mm_mul_ps( o_sine, angleSquared ), _mm_set1_ps( _c_sinCoefficient3 ) );
+    o_sine = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( o_sine, angleSquared ), i_angle ), i_angle );
+
+    o_cosine = _mm_set1_ps( _c_cosCoefficient8 );
+    o_cosine = _mm_add_ps( _mm_mul_ps( o_cosine, angleSquared ), _mm_set1_ps( _c_cosCoefficient6 ) );
+    o_cosine = _mm_add_ps( _mm_mul_ps( o_cosine, angleSquared ), _mm_set1_ps( _c_cosCoefficient4 ) );
+    o_cosine = _mm_add_ps( _mm_mul_ps( o_cosine, angleSquared ), _mm_set1_ps( _c_cosCoefficient2 ) );
+    o_cosine = _mm_add_ps( _mm_mul_ps( o_cosine, angleSquared ), _mm_set1_ps( 1.0f ) );
+}
+/// \endcond
+
+/// Map the \p i_count uniform samples \p i_samples onto the unit disk, 4 samples at a time using SSE2.
+///
+/// \sa ConcentricDiskSamplesScalar
+inline void ConcentricDiskSamplesSSE2( const gm::Vec2f* i_samples, size_t i_count, gm::Vec2f* o_points )
+{
+    const __m128 one         = _mm_set1_ps( 1.0f );
+    const __m128 two         = _mm_set1_ps( 2.0f );
+    const __m128 zero        = _mm_setzero_ps();
+    const __m128 absMask     = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+    const __m128 quarterPi   = _mm_set1_ps( gm::Pi * 0.25f );
+    const size_t vectorCount = i_count - i_count % 4;
+
+    for ( size_t sampleIndex = 0; sampleIndex < vectorCount; sampleIndex += 4 )
+    {
+        __m128 sampleX;
+        __m128 sampleY;
+        _LoadSamplesSSE2( i_samples + sampleIndex, sampleX, sampleY );
+
+        const __m128 a = _mm_sub_ps( _mm_mul_ps( sampleX, two ), one );
+        const __m128 b = _mm_sub_ps( _mm_mul_ps( sampleY, two ), one );
+
+        const __m128 major   = _mm_cmpgt_ps( _mm_and_ps( a, absMask ), _mm_and_ps( b, absMask ) );
+        const __m128 radius  = _SelectSSE2( major, a, b );
+        const __m128 divisor = _SelectSSE2( _mm_cmpneq_ps( radius, zero ), radius, one );
+        const __m128 ratio   = _mm_div_ps( _SelectSSE2( major, b, a ), divisor );
+
+        __m128 sine;
+        __m128 cosine;
+        _SinCosQuarterPiSSE2( _mm_mul_ps( ratio, quarterPi ), sine, cosine );
+
+        const __m128 pointX = _mm_mul_ps( radius, _SelectSSE2( major, cosine, sine ) );
+        const __m128 pointY = _mm_mul_ps( radius, _SelectSSE2( major, sine, cosine ) );
+
+        // Interleave the coordinates back into points.
+        _mm_storeu_ps( &o_points[ sampleIndex ].X(), _mm_unpacklo_ps( pointX, pointY ) );
+        _mm_storeu_ps( &o_points[ sampleIndex + 2 ].X(), _mm_unpackhi_ps( pointX, pointY ) );
+    }
+
+    ConcentricDiskSamplesScalar( i_samples + vectorCount, i_count - vectorCount, o_points + vectorCount );
+}
+
+/// Map the \p i_count uniform samples \p i_samples onto the unit sphere, 4 samples at a time using SSE2.
+///
+/// \sa UniformSphereSamplesScalar
+inline void UniformSphereSamplesSSE2( const gm::Vec2f* i_samples, size_t i_count, gm::Vec3f* o_directions )
+{
+    const __m128  one         = _mm_set1_ps( 1.0f );
+    const __m128  two         = _mm_set1_ps( 2.0f );
+    const __m128  four        = _mm_set1_ps( 4.0f );
+    const __m128  half        = _mm_set1_ps( 0.5f );
+    const __m128  halfPi      = _mm_set1_ps( gm::HalfPi );
+    const __m128i oneInt      = _mm_set1_epi32( 1 );
+    const __m128i twoInt      = _mm_set1_epi32( 2 );
+    const size_t  vectorCount = i_count - i_count % 4;
+
+    for ( size_t sampleIndex = 0; sampleIndex < vectorCount; sampleIndex += 4 )
+    {
+        __m128 sampleX;
+        __m128 sampleY;
+        _LoadSamplesSSE2( i_samples + sampleIndex, sampleX, sampleY );
+
+        const __m128 z      = _mm_sub_ps( _mm_mul_ps( sampleY, two ), one );
+        const __m128 radius = _mm_sqrt_ps( _mm_max_ps( _mm_setzero_ps(), _mm_sub_ps( one, _mm_mul_ps( z, z ) ) ) );
+
+        // Reduce to the nearest quarter turn, as per SinCosTurns.
+        const __m128  quarterTurns = _mm_mul_ps( sampleX, four );
+        const __m128i quadrant     = _mm_cvttps_epi32( _mm_add_ps( quarterTurns, half ) );
+        const __m128  remainder    = _mm_sub_ps( quarterTurns, _mm_cvtepi32_ps( quadrant ) );
+
+        __m128 sine;
+        __m128 cosine;
+        _SinCosQuarterPiSSE2( _mm_mul_ps( remainder, halfPi ), sine, cosine );
+
+        // Rotate by the quadrant, by swapping, then flipping the sign bits.
+        const __m128 swap       = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( quadrant, oneInt ), oneInt ) );
+        const __m128 sineSign   = _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( quadrant, twoInt ), 30 ) );
+        const __m128 cosineSign = _mm_castsi128_ps(
+            _mm_slli_epi32( _mm_and_si128( _mm_add_epi32( quadrant, oneInt ), twoInt ), 30 ) );
+
+        const __m128 rotatedSine   = _mm_xor_ps( _SelectSSE2( swap, cosine, sine ), sineSign );
+        const __m128 rotatedCosine = _mm_xor_ps( _SelectSSE2( swap, sine, cosine ), cosineSign );
+
+        alignas( 16 ) float directionX[ 4 ];
+        alignas( 16 ) float directionY[ 4 ];
+        alignas( 16 ) float directionZ[ 4 ];
+        _mm_store_ps( directionX, _mm_mul_ps( radius, rotatedCosine ) );
+        _mm_store_ps( directionY, _mm_mul_ps( radius, rotatedSine ) );
+        _mm_store_ps( directionZ, z );
+        for ( int lane = 0; lane < 4; ++lane )
+        {
+            o_directions[ sampleIndex + lane ] =
+                gm::Vec3f( directionX[ lane ], directionY[ lane ], directionZ[ lane ] );
+        }
+    }
+
+    UniformSphereSamplesScalar( i_samples + vectorCount, i_count - vectorCount, o_directions + vectorCount );
+}
+
+#endif // RAYTRACE_X86
+
+/// Map the \p i_count uniform samples \p i_samples onto the unit disk, using the widest kernel supported by the
+/// executing CPU.
+///
+/// \param i_samples The uniform samples.
+/// \param i_count The number of samples.
+/// \param o_points The points in the unit disk, one per sample.  May be the same array as \p i_samples.
+///
+/// \sa ConcentricDiskSample
+inline void ConcentricDiskSamples( const gm::Vec2f* i_samples, size_t i_count, gm::Vec2f* o_points )
+{
+#if defined( RAYTRACE_X86 )
+    if ( DetectSIMDLevel() != SIMDLevel::Scalar )
+    {
+        ConcentricDiskSamplesSSE2( i_samples, i_count, o_points );
+        return;
+    }
+#endif
+    ConcentricDiskSamplesScalar( i_samples, i_count, o_points );
+}
+
+/// Map the \p i_count uniform samples \p i_samples onto the unit sphere, using the widest kernel supported by the
+/// executing CPU.
+///
+/// \param i_samples The uniform samples.
+/// \param i_count The number of samples.
+/// \param o_directions The unit vectors, one per sample.
+///
+/// \sa UniformSphereSample
+inline void UniformSphereSamples( const gm::Vec2f* i_samples, size_t i_count, gm::Vec3f* o_directions )
+{
+#if defined( RAYTRACE_X86 )
+    if ( DetectSIMDLevel() != SIMDLevel::Scalar )
+    {
+        UniformSphereSamplesSSE2( i_samples, i_count, o_directions );
+        return;
+    }
+#endif
+    UniformSphereSamplesScalar( i_samples, i_count, o_directions );
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,176 @@
+/// \file raytrace/sampler.cpp
+
+#include <raytrace/sampler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \var c_blueNoiseSigma
+///
+/// Standard deviation of the Gaussian energy filter of the void-and-cluster method, in pixels.
+static constexpr float c_blueNoiseSigma = 1.5f;
+
+/// \var c_blueNoiseInitialDivisor
+///
+/// One in this many pixels are set in the initial binary pattern.
+static constexpr int c_blueNoiseInitialDivisor = 10;
+
+/// \class BlueNoiseGenerator
+///
+/// State of the void-and-cluster method (Ulichney, "The void-and-cluster method for dither array generation"):
+/// a binary pattern over a toroidal tile, and the energy of each pixel, which is the sum of the Gaussian filtered
+/// distance to each set pixel.  Tight clusters of set pixels have the highest energy, large voids the lowest.
+class BlueNoiseGenerator final
+{
+public:
+    BlueNoiseGenerator()
+        : m_kernel( c_pixelCount )
+        , m_pattern( c_pixelCount, 0 )
+        , m_energy( c_pixelCount, 0.0f )
+    {
+        for ( int yOffset = 0; yOffset < c_blueNoiseTileSize; ++yOffset )
+        {
+            for ( int xOffset = 0; xOffset < c_blueNoiseTileSize; ++xOffset )
+            {
+                // Wrapped distance within the tile.
+                const int   xDistance       = std::min( xOffset, c_blueNoiseTileSize - xOffset );
+                const int   yDistance       = std::min( yOffset, c_blueNoiseTileSize - yOffset );
+                const float distanceSquared = float( xDistance * xDistance + yDistance * yDistance );
+                m_kernel[ yOffset * c_blueNoiseTileSize + xOffset ] =
+                    std::exp( -distanceSquared / ( 2.0f * c_blueNoiseSigma * c_blueNoiseSigma ) );
+            }
+        }
+    }
+
+    /// Set or clear pixel \p i_pixelIndex of the pattern.
+    void Set( int i_pixelIndex, bool i_value )
+    {
+        m_pattern[ i_pixelIndex ] = i_value ? 1 : 0;
+
+        const int   xCoord = i_pixelIndex % c_blueNoiseTileSize;
+        const int   yCoord = i_pixelIndex / c_blueNoiseTileSize;
+        const float sign   = i_value ? 1.0f : -1.0f;
+        for ( int pixelIndex = 0; pixelIndex < c_pixelCount; ++pixelIndex )
+        {
+            const int xOffset = ( pixelIndex % c_blueNoiseTileSize - xCoord ) & c_tileMask;
+            const int yOffset = ( pixelIndex / c_blueNoiseTileSize - yCoord ) & c_tileMask;
+            m_energy[ pixelIndex ] += sign * m_kernel[ yOffset * c_blueNoiseTileSize + xOffset ];
+        }
+    }
+
+    /// Check if pixel \p i_pixelIndex of the pattern is set.
+    bool IsSet( int i_pixelIndex ) const
+    {
+        return m_pattern[ i_pixelIndex ] != 0;
+    }
+
+    /// Find the set pixel of highest energy.
+    int TightestCluster() const
+    {
+        return _FindExtremum( 1, 1.0f );
+    }
+
+    /// Find the clear pixel of lowest energy.
+    int LargestVoid() const
+    {
+        return _FindExtremum( 0, -1.0f );
+    }
+
+    static constexpr int c_pixelCount = c_blueNoiseTileSize * c_blueNoiseTileSize;
+
+private:
+    // Wraps an offset into the tile, which is a power of two wide.
+    static constexpr int c_tileMask = c_blueNoiseTileSize - 1;
+
+    // Find the pixel of value \p i_value, whose energy scaled by \p i_sign is highest.
+    int _FindExtremum( uint8_t i_value, float i_sign ) const
+    {
+        int   extremumIndex  = -1;
+        float extremumEnergy = 0.0f;
+        for ( int pixelIndex = 0; pixelIndex < c_pixelCount; ++pixelIndex )
+        {
+            if ( m_pattern[ pixelIndex ] == i_value &&
+                 ( extremumIndex < 0 || i_sign * m_energy[ pixelIndex ] > extremumEnergy ) )
+            {
+                extremumIndex  = pixelIndex;
+                extremumEnergy = i_sign * m_energy[ pixelIndex ];
+            }
+        }
+
+        return extremumIndex;
+    }
+
+    std::vector< float >   m_kernel;
+    std::vector< uint8_t > m_pattern;
+    std::vector< float >   m_energy;
+};
+
+/// Generate the ranks of a blue noise mask with the void-and-cluster method.
+static std::vector< uint16_t > GenerateBlueNoiseMask()
+{
+    constexpr int           pixelCount = BlueNoiseGenerator::c_pixelCount;
+    std::vector< uint16_t > ranks( pixelCount, 0 );
+
+    // Initial binary pattern of pixels chosen at random, with a fixed seed.
+    BlueNoiseGenerator generator;
+    int                setCount = 0;
+    uint32_t           state    = 0x2545F491u;
+    while ( setCount < pixelCount / c_blueNoiseInitialDivisor )
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        const int pixelIndex = static_cast< int >( state % pixelCount );
+        if ( !generator.IsSet( pixelIndex ) )
+        {
+            generator.Set( pixelIndex, true );
+            ++setCount;
+        }
+    }
+
+    // Relax the initial pattern into evenly spread pixels, by moving the tightest cluster into the largest void
+    // until the two coincide.
+    for ( int iteration = 0; iteration < pixelCount; ++iteration )
+    {
+        const int cluster = generator.TightestCluster();
+        generator.Set( cluster, false );
+        const int largestVoid = generator.LargestVoid();
+        generator.Set( largestVoid, true );
+        if ( largestVoid == cluster )
+        {
+            break;
+        }
+    }
+
+    // Rank the pixels of the relaxed pattern by removing its tightest clusters first.
+    const BlueNoiseGenerator prototype = generator;
+    for ( int rank = setCount - 1; rank >= 0; --rank )
+    {
+        const int cluster = generator.TightestCluster();
+        generator.Set( cluster, false );
+        ranks[ cluster ] = static_cast< uint16_t >( rank );
+    }
+
+    // Rank the remaining pixels by filling the largest void first.
+    generator = prototype;
+    for ( int rank = setCount; rank < pixelCount; ++rank )
+    {
+        const int largestVoid = generator.LargestVoid();
+        generator.Set( largestVoid, true );
+        ranks[ largestVoid ] = static_cast< uint16_t >( rank );
+    }
+
+    return ranks;
+}
+
+const uint16_t* BlueNoiseMask()
+{
+    static const std::vector< uint16_t > s_mask = GenerateBlueNoiseMask();
+    return s_mask.data();
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,303 @@
+#pragma once
+
+/// \file raytrace/sampler.h
+///
+/// Sample sequences over the dimensions of a pixel sample, with lower discrepancy than independent random numbers.
+
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec2f.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+RAYTRACE_NS_OPEN
+
+/// \enum SamplerType
+///
+/// The sequence from which the samples of each pixel are drawn.
+enum class SamplerType
+{
+    Independent = 0, ///< Independent random numbers.
+    Stratified,      ///< Jittered strata of the pixel samples, shuffled per pair of dimensions.
+    Sobol,           ///< Owen-scrambled Sobol (0,2)-sequence, shuffled per pair of dimensions.
+    BlueNoise        ///< Sobol sequence shared by all pixels, offset per pixel by a tiled blue noise mask.
+};
+
+/// Get the sampler type named \p i_name ("independent", "stratified", "sobol", or "blueNoise").
+///
+/// \return false if \p i_name is not the name of a sampler type.
+inline bool SamplerTypeFromName( const std::string& i_name, SamplerType& o_type )
+{
+    const std::pair< const char*, SamplerType > types[] = {{"independent", SamplerType::Independent},
+                                                           {"stratified", SamplerType::Stratified},
+                                                           {"sobol", SamplerType::Sobol},
+                                                           {"blueNoise", SamplerType::BlueNoise}};
+    for ( const auto& type : types )
+    {
+        if ( i_name == type.first )
+        {
+            o_type = type.second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// \var c_blueNoiseTileSize
+///
+/// Width & height of the blue noise mask, which is tiled over the image.
+constexpr int c_blueNoiseTileSize = 64;
+
+/// Get the blue noise mask, of \ref c_blueNoiseTileSize squared pixels in scanline order.  Each pixel holds its
+/// rank, a unique value in [0, c_blueNoiseTileSize squared), such that the pixels below any rank threshold are
+/// evenly spread.
+///
+/// The mask is generated with the void-and-cluster method upon the first call.
+const uint16_t* BlueNoiseMask();
+
+/// \class Sampler
+///
+/// A Sampler produces the sample values of each pixel sample, indexed by the pixel, the sample, and the
+/// dimension.  The dimensions are consumed in pairs, and each pair is a 2D point set over the samples of a pixel,
+/// such that the samples of a pixel cover the pixel area, lens, and scattering directions more evenly than
+/// independent random numbers.
+///
+/// Sampling is a pure function of its indices, thus independent of the thread & order of evaluation.
+class Sampler final
+{
+public:
+    /// Construct a sampler of type \p i_type.
+    ///
+    /// \param i_type The sample sequence.
+    /// \param i_imageWidth Width of the image, mapping pixel indices to coordinates.
+    /// \param i_samplesPerPixel The expected number of samples per-pixel, over which samples are stratified.
+    /// \param i_seed Seed, to produce a different sequence for an otherwise identical render.
+    inline explicit Sampler( SamplerType i_type, int i_imageWidth, int i_samplesPerPixel, uint32_t i_seed )
+        : m_type( i_type )
+        , m_imageWidth( static_cast< uint32_t >( std::max( i_imageWidth, 1 ) ) )
+        , m_strataPerAxis( static_cast< uint32_t >( std::max( std::sqrt( float( i_samplesPerPixel ) ), 1.0f ) ) )
+        , m_seed( _Hash( i_seed ) )
+        , m_blueNoiseMask( i_type == SamplerType::BlueNoise ? BlueNoiseMask() : nullptr )
+    {
+    }
+
+    /// Get the type of sample sequence.
+    inline SamplerType Type() const
+    {
+        return m_type;
+    }
+
+    /// Get the 2D sample of the dimension pair \p i_dimensionPair, of a pixel sample.
+    ///
+    /// \param i_pixelIndex The linear index of the pixel.
+    /// \param i_sampleIndex The index of the sample within the pixel.
+    /// \param i_dimensionPair The index of the dimension pair.
+    ///
+    /// \return The sample, within [0, 1) along each axis.
+    inline gm::Vec2f Sample2D( uint32_t i_pixelIndex, uint32_t i_sampleIndex, uint32_t i_dimensionPair ) const
+    {
+        uint32_t xValue;
+        uint32_t yValue;
+        _Sample2D( i_pixelIndex, i_sampleIndex, i_dimensionPair, xValue, yValue );
+        return gm::Vec2f( _ToUnitFloat( xValue ), _ToUnitFloat( yValue ) );
+    }
+
+    /// Get the sample of dimension \p i_dimension, of a pixel sample.  Dimensions 2n & 2n+1 are the axes of
+    /// \ref Sample2D of pair n.
+    ///
+    /// \return The sample, within [0, 1).
+    inline float Sample1D( uint32_t i_pixelIndex, uint32_t i_sampleIndex, uint32_t i_dimension ) const
+    {
+        uint32_t xValue;
+        uint32_t yValue;
+        _Sample2D( i_pixelIndex, i_sampleIndex, i_dimension >> 1, xValue, yValue );
+        return _ToUnitFloat( ( i_dimension & 1 ) == 0 ? xValue : yValue );
+    }
+
+private:
+    // Compute the 2D sample as 32-bit fixed-point values in [0, 1).
+    inline void _Sample2D( uint32_t  i_pixelIndex,
+                           uint32_t  i_sampleIndex,
+                           uint32_t  i_dimensionPair,
+                           uint32_t& o_xValue,
+                           uint32_t& o_yValue ) const
+    {
+        switch ( m_type )
+        {
+        case SamplerType::Stratified:
+        {
+            // Each set of strata is visited in a random order, which differs per pixel & dimension pair.
+            const uint32_t strataCount = m_strataPerAxis * m_strataPerAxis;
+            const uint32_t setSeed     = _HashCombine(
+                _HashCombine( _HashCombine( m_seed, i_pixelIndex ), i_dimensionPair ), i_sampleIndex / strataCount );
+            const uint32_t stratum = _Permute( i_sampleIndex % strataCount, strataCount, setSeed );
+            const uint32_t jitterX = _HashCombine( setSeed, 2 * i_sampleIndex ) >> 8;
+            const uint32_t jitterY = _HashCombine( setSeed, 2 * i_sampleIndex + 1 ) >> 8;
+
+            // Scale the jittered stratum into the 32-bit range, in 64-bit to avoid overflow.
+            const uint64_t strataScale = ( uint64_t( 1 ) << 32 ) / m_strataPerAxis;
+            const uint64_t xStratum    = stratum % m_strataPerAxis;
+            const uint64_t yStratum    = stratum / m_strataPerAxis;
+            o_xValue = static_cast< uint32_t >( xStratum * strataScale + ( ( jitterX * strataScale ) >> 24 ) );
+            o_yValue = static_cast< uint32_t >( yStratum * strataScale + ( ( jitterY * strataScale ) >> 24 ) );
+            break;
+        }
+        case SamplerType::Sobol:
+            _SobolSample( i_sampleIndex,
+                          _HashCombine( _HashCombine( m_seed, i_pixelIndex ), i_dimensionPair ),
+                          o_xValue,
+                          o_yValue );
+            break;
+        case SamplerType::BlueNoise:
+        {
+            // The pixels share a sequence, which is offset (toroidally) per pixel by the blue noise mask, such that
+            // the error is distributed over the image as blue noise.
+            const uint32_t pairSeed = _HashCombine( m_seed, i_dimensionPair );
+            _SobolSample( i_sampleIndex, pairSeed, o_xValue, o_yValue );
+
+            const uint32_t xCoord      = i_pixelIndex % m_imageWidth;
+            const uint32_t yCoord      = i_pixelIndex / m_imageWidth;
+            const uint32_t offsetSeed  = _Hash( pairSeed );
+            const uint32_t rankToValue = 32 - 2 * c_blueNoiseTileSizeLog2;
+            o_xValue += uint32_t( _BlueNoiseRank( xCoord + offsetSeed, yCoord + ( offsetSeed >> 8 ) ) ) << rankToValue;
+            o_yValue += uint32_t( _BlueNoiseRank( xCoord + ( offsetSeed >> 16 ), yCoord + ( offsetSeed >> 24 ) ) )
+                        << rankToValue;
+            break;
+        }
+        default:
+            o_xValue = _HashCombine( _HashCombine( _HashCombine( m_seed, i_pixelIndex ), i_sampleIndex ),
+                                     2 * i_dimensionPair );
+            o_yValue = _HashCombine( _HashCombine( _HashCombine( m_seed, i_pixelIndex ), i_sampleIndex ),
+                                     2 * i_dimensionPair + 1 );
+            break;
+        }
+    }
+
+    // Compute sample \p i_sampleIndex of the 2D Sobol sequence, Owen-scrambled by \p i_seed.  The sample index is
+    // shuffled by a nested uniform scramble too, which keeps each power-of-two prefix of the sequence a (0,2)-net,
+    // while decorrelating the sequences of different seeds.
+    static inline void _SobolSample( uint32_t i_sampleIndex, uint32_t i_seed, uint32_t& o_xValue, uint32_t& o_yValue )
+    {
+        const uint32_t index = _NestedUniformScramble( i_sampleIndex, i_seed );
+        o_xValue             = _NestedUniformScramble( _ReverseBits( index ), _HashCombine( i_seed, 1 ) );
+        o_yValue             = _NestedUniformScramble( _SobolSecondDimension( index ), _HashCombine( i_seed, 2 ) );
+    }
+
+    // Second dimension of the Sobol sequence, whose direction numbers follow from the primitive polynomial x + 1.
+    static inline uint32_t _SobolSecondDimension( uint32_t i_index )
+    {
+        uint32_t value     = 0;
+        uint32_t direction = 1u << 31;
+        for ( ; i_index != 0; i_index >>= 1, direction ^= direction >> 1 )
+        {
+            if ( ( i_index & 1 ) != 0 )
+            {
+                value ^= direction;
+            }
+        }
+
+        return value;
+    }
+
+    static inline uint32_t _ReverseBits( uint32_t i_value )
+    {
+        i_value = ( ( i_value >> 1 ) & 0x55555555u ) | ( ( i_value & 0x55555555u ) << 1 );
+        i_value = ( ( i_value >> 2 ) & 0x33333333u ) | ( ( i_value & 0x33333333u ) << 2 );
+        i_value = ( ( i_value >> 4 ) & 0x0F0F0F0Fu ) | ( ( i_value & 0x0F0F0F0Fu ) << 4 );
+        i_value = ( ( i_value >> 8 ) & 0x00FF00FFu ) | ( ( i_value & 0x00FF00FFu ) << 8 );
+        return ( i_value >> 16 ) | ( i_value << 16 );
+    }
+
+    // Owen scrambling of the bits of \p i_value, where each bit is flipped depending on the bits above it.  Built
+    // from the Laine-Karras permutation, with the constants of Burley, "Practical Hash-based Owen Scrambling".
+    static inline uint32_t _NestedUniformScramble( uint32_t i_value, uint32_t i_seed )
+    {
+        uint32_t value = _ReverseBits( i_value );
+        value ^= value * 0x3D20ADEAu;
+        value += i_seed;
+        value *= ( i_seed >> 16 ) | 1;
+        value ^= value * 0x05526C56u;
+        value ^= value * 0x53A22864u;
+        return _ReverseBits( value );
+    }
+
+    // Random permutation of \p i_index within [0, i_length), from Kensler, "Correlated Multi-Jittered Sampling".
+    static inline uint32_t _Permute( uint32_t i_index, uint32_t i_length, uint32_t i_seed )
+    {
+        uint32_t mask = i_length - 1;
+        mask |= mask >> 1;
+        mask |= mask >> 2;
+        mask |= mask >> 4;
+        mask |= mask >> 8;
+        mask |= mask >> 16;
+        do
+        {
+            i_index ^= i_seed;
+            i_index *= 0xE170893Du;
+            i_index ^= i_seed >> 16;
+            i_index ^= ( i_index & mask ) >> 4;
+            i_index ^= i_seed >> 8;
+            i_index *= 0x0929EB3Fu;
+            i_index ^= i_seed >> 23;
+            i_index ^= ( i_index & mask ) >> 1;
+            i_index *= 1 | i_seed >> 27;
+            i_index *= 0x6935FA69u;
+            i_index ^= ( i_index & mask ) >> 11;
+            i_index *= 0x74DCB303u;
+            i_index ^= ( i_index & mask ) >> 2;
+            i_index *= 0x9E501CC3u;
+            i_index ^= ( i_index & mask ) >> 2;
+            i_index *= 0xC860A3DFu;
+            i_index &= mask;
+            i_index ^= i_index >> 5;
+        } while ( i_index >= i_length );
+
+        return ( i_index + i_seed ) % i_length;
+    }
+
+    // Rank of the blue noise mask at the coordinate, wrapped into the tile.
+    inline uint16_t _BlueNoiseRank( uint32_t i_xCoord, uint32_t i_yCoord ) const
+    {
+        const uint32_t tileMask = c_blueNoiseTileSize - 1;
+        return m_blueNoiseMask[ ( i_yCoord & tileMask ) * c_blueNoiseTileSize + ( i_xCoord & tileMask ) ];
+    }
+
+    // 32-bit integer hash, with low bias.
+    static inline uint32_t _Hash( uint32_t i_value )
+    {
+        i_value ^= i_value >> 16;
+        i_value *= 0x7FEB352Du;
+        i_value ^= i_value >> 15;
+        i_value *= 0x846CA68Bu;
+        i_value ^= i_value >> 16;
+        return i_value;
+    }
+
+    static inline uint32_t _HashCombine( uint32_t i_seed, uint32_t i_value )
+    {
+        return _Hash( i_seed ^ ( i_value + 0x9E3779B9u + ( i_seed << 6 ) + ( i_seed >> 2 ) ) );
+    }
+
+    // Map the upper 24 bits of a 32-bit fixed-point value into a float in [0, 1), as RandomNumberGenerator does.
+    static inline float _ToUnitFloat( uint32_t i_value )
+    {
+        return static_cast< float >( i_value >> 8 ) * ( 1.0f / 16777216.0f );
+    }
+
+    // log2 of c_blueNoiseTileSize.
+    static constexpr uint32_t c_blueNoiseTileSizeLog2 = 6;
+    static_assert( ( 1 << c_blueNoiseTileSizeLog2 ) == c_blueNoiseTileSize, "Mismatching blue noise tile size." );
+
+    SamplerType     m_type          = SamplerType::Independent;
+    uint32_t        m_imageWidth    = 1;
+    uint32_t        m_strataPerAxis = 1;
+    uint32_t        m_seed          = 0;
+    const uint16_t* m_blueNoiseMask = nullptr;
+};
+
+RAYTRACE_NS_CLOSE
@@ -7,12 +7,17 @@
 #include <raytrace/raytrace.h>
 
 #include <gm/types/floatRange.h>
+#include <gm/types/vec3fRange.h>
 #include <raytrace/ray.h>
 
 #include <memory>
+#include <vector>
 
 RAYTRACE_NS_OPEN
 
+// Forward declarations.
+class MaterialTable;
+
 /// \class SceneObject
 ///
 /// SceneObject is the base class for all scene objects which are \em subject to ray tracing.
@@ -32,6 +37,30 @@ public:
     /// \retval false If the ray does not hit this object, or if the hit is outside the range
     /// of \p i_magnitudeRange.
     virtual bool Hit( const Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const = 0;
+
+    /// Compute the axis-aligned bounding box enclosing this object.
+    ///
+    /// \return The bounding box of this object.
+    virtual gm::Vec3fRange BoundingBox() const = 0;
+
+    /// Register the materials of this object into \p io_materials, such that hits against this object report the
+    /// index of their material into it, through \ref HitRecord::m_materialIndex.
+    ///
+    /// Compiling into another table re-targets the indices.  The table must outlive this object.
+    ///
+    /// \param io_materials The table to add materials into.
+    virtual void CompileMaterials( MaterialTable& /* io_materials */ )
+    {
+    }
+
+    /// Get the material table which the hits against this object index into.
+    ///
+    /// \return The material table, or nullptr if the materials of this object have not been compiled, in which case
+    /// hits are scattered through \ref Material::Scatter.
+    virtual const MaterialTable* Materials() const
+    {
+        return nullptr;
+    }
 };
 
 /// \typedef SceneObjectPtr
@@ -39,4 +68,9 @@ public:
 /// Pointer to the scene object.
 using SceneObjectPtr = std::unique_ptr< SceneObject >;
 
+/// \typedef SceneObjectPtrs
+///
+/// A collection of scene objects.
+using SceneObjectPtrs = std::vector< SceneObjectPtr >;
+
 RAYTRACE_NS_CLOSE
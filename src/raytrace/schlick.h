@@ -12,7 +12,7 @@ RAYTRACE_NS_OPEN
 ///
 /// \param i_cosine The cosine of the angle formed by the incident ray and surface normal.
 /// \param i_refractionIndex The ratio of the refractive indices.
-float Schlick( float i_cosine, float i_refractionIndex )
+inline float Schlick( float i_cosine, float i_refractionIndex )
 {
     auto r0 = ( 1 - i_refractionIndex ) / ( 1 + i_refractionIndex );
     r0      = r0 * r0;
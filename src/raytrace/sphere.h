@@ -4,12 +4,15 @@
 ///
 /// Representation of a ray-traceable sphere.
 
+#include <raytrace/materialTable.h>
 #include <raytrace/raytrace.h>
 #include <raytrace/sceneObject.h>
+#include <raytrace/sphereIntersection.h>
 
 #include <gm/functions/normalize.h>
 #include <gm/functions/rayPosition.h>
-#include <gm/functions/raySphereIntersection.h>
+
+#include <cmath>
 
 RAYTRACE_NS_OPEN
 
@@ -35,25 +38,36 @@ public:
     virtual inline bool
     Hit( const Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
     {
-        gm::FloatRange intersections;
-        if ( RaySphereIntersection( m_origin, m_radius, i_ray.Origin(), i_ray.Direction(), intersections ) > 0 )
+        float magnitude;
+        if ( RaySphereNearestHit( m_origin, m_radius, i_ray, i_magnitudeRange, magnitude ) )
         {
-            if ( intersections.Min() < i_magnitudeRange.Max() && intersections.Min() > i_magnitudeRange.Min() )
-            {
-                _Record( i_ray, intersections.Min(), o_record );
-                return true;
-            }
-            else if ( intersections.Max() < i_magnitudeRange.Max() && intersections.Max() > i_magnitudeRange.Min() )
-            {
-                _Record( i_ray, intersections.Max(), o_record );
-                return true;
-            }
+            _Record( i_ray, magnitude, o_record );
+            return true;
         }
 
         // Sorry, missed!
         return false;
     }
 
+    virtual inline gm::Vec3fRange BoundingBox() const override
+    {
+        // The radius may be negative, to model a hollow sphere with inward facing normals.
+        const float     absRadius = std::abs( m_radius );
+        const gm::Vec3f extent( absRadius, absRadius, absRadius );
+        return gm::Vec3fRange( m_origin - extent, m_origin + extent );
+    }
+
+    virtual inline void CompileMaterials( MaterialTable& io_materials ) override
+    {
+        m_materialIndex = io_materials.Add( m_material );
+        m_materialTable = &io_materials;
+    }
+
+    virtual inline const MaterialTable* Materials() const override
+    {
+        return m_materialTable;
+    }
+
 private:
     /// Helper method to record a ray hitting the sphere.
     ///
@@ -62,10 +76,11 @@ private:
     /// \param o_record the record of a ray hit.
     inline void _Record( const Ray& i_ray, float i_rayMagnitude, HitRecord& o_record ) const
     {
-        o_record.m_position  = RayPosition( i_ray.Origin(), i_ray.Direction(), i_rayMagnitude );
-        o_record.m_normal    = ( o_record.m_position - m_origin ) / m_radius;
-        o_record.m_magnitude = i_rayMagnitude;
-        o_record.m_material  = m_material;
+        o_record.m_position      = RayPosition( i_ray.Origin(), i_ray.Direction(), i_rayMagnitude );
+        o_record.m_normal        = ( o_record.m_position - m_origin ) / m_radius;
+        o_record.m_magnitude     = i_rayMagnitude;
+        o_record.m_material      = m_material.get();
+        o_record.m_materialIndex = m_materialIndex;
     }
 
     // The origin of the sphere.
@@ -76,6 +91,10 @@ private:
 
     // Assigned material.
     MaterialSharedPtr m_material;
+
+    // The table which the material has been compiled into, and its index.
+    const MaterialTable* m_materialTable = nullptr;
+    uint32_t             m_materialIndex = c_invalidMaterialIndex;
 };
 
 RAYTRACE_NS_CLOSE
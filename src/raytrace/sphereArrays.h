@@ -0,0 +1,108 @@
+#pragma once
+
+/// \file raytrace/sphereArrays.h
+///
+/// Structure-of-arrays storage of sphere geometry.
+
+#include <raytrace/alignedAllocator.h>
+#include <raytrace/raytrace.h>
+
+#include <gm/types/vec3f.h>
+
+RAYTRACE_NS_OPEN
+
+/// \class SphereArrays
+///
+/// Sphere centers and radii stored as separate, contiguous & aligned float arrays, such that a block of
+/// spheres can be loaded into vector registers lane-by-lane.
+///
+/// The arrays are padded with zeroes up to a multiple of \ref c_laneCount elements, so vectorized kernels
+/// can process whole blocks without bounds checks on loads.  Padded elements must be masked out by
+/// comparing against \ref Size.
+class SphereArrays final
+{
+public:
+    /// \var c_laneCount
+    ///
+    /// The array padding granularity, matching the widest supported vector width.
+    static constexpr size_t c_laneCount = 8;
+
+    /// Append a sphere.
+    ///
+    /// \param i_center The center of the sphere.
+    /// \param i_radius The radius of the sphere.
+    inline void Append( const gm::Vec3f& i_center, float i_radius )
+    {
+        if ( m_size % c_laneCount == 0 )
+        {
+            // Grow all arrays by a full block of padding.
+            size_t paddedSize = m_size + c_laneCount;
+            m_centerX.resize( paddedSize, 0.0f );
+            m_centerY.resize( paddedSize, 0.0f );
+            m_centerZ.resize( paddedSize, 0.0f );
+            m_radius.resize( paddedSize, 0.0f );
+        }
+
+        m_centerX[ m_size ] = i_center.X();
+        m_centerY[ m_size ] = i_center.Y();
+        m_centerZ[ m_size ] = i_center.Z();
+        m_radius[ m_size ]  = i_radius;
+        m_size++;
+    }
+
+    /// Get the number of spheres.
+    inline size_t Size() const
+    {
+        return m_size;
+    }
+
+    /// Get the number of elements in each array, including padding.
+    inline size_t PaddedSize() const
+    {
+        return m_radius.size();
+    }
+
+    /// Get the center of the sphere at \p i_index.
+    inline gm::Vec3f Center( size_t i_index ) const
+    {
+        return gm::Vec3f( m_centerX[ i_index ], m_centerY[ i_index ], m_centerZ[ i_index ] );
+    }
+
+    /// Get the radius of the sphere at \p i_index.
+    inline float Radius( size_t i_index ) const
+    {
+        return m_radius[ i_index ];
+    }
+
+    /// \name Raw array access, for vectorized kernels.
+    /// \{
+    inline const float* CenterXData() const
+    {
+        return m_centerX.data();
+    }
+
+    inline const float* CenterYData() const
+    {
+        return m_centerY.data();
+    }
+
+    inline const float* CenterZData() const
+    {
+        return m_centerZ.data();
+    }
+
+    inline const float* RadiusData() const
+    {
+        return m_radius.data();
+    }
+    /// \}
+
+private:
+    size_t            m_size = 0;
+    AlignedFloatArray m_centerX;
+    AlignedFloatArray m_centerY;
+    AlignedFloatArray m_centerZ;
+    AlignedFloatArray m_radius;
+};
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,339 @@
+#pragma once
+
+/// \file raytrace/sphereIntersection.h
+///
+/// Ray sphere intersection kernels.
+///
+/// A scalar kernel tests a single ray against a single sphere.  The array kernels test a single ray against
+/// every sphere in a \ref SphereArrays, 4 (SSE2) or 8 (AVX2) spheres at a time, and are selected at run-time
+/// based on the instruction sets supported by the CPU.
+///
+/// All kernels solve the quadratic with the "half b" formulation, which requires a single square root per
+/// sphere:
+///
+/// \f$t=\frac{-h\pm\sqrt{h^2-ac}}{a}\f$ where \f$a=D\cdot D\f$, \f$h=D\cdot(O-C)\f$, and \f$c=(O-C)^2-R^2\f$.
+
+#include <raytrace/cpuFeatures.h>
+#include <raytrace/ray.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/sphereArrays.h>
+
+#include <gm/functions/dotProduct.h>
+#include <gm/types/floatRange.h>
+#include <gm/types/vec3f.h>
+
+#include <cmath>
+
+#if defined( RAYTRACE_X86 )
+#include <immintrin.h>
+#endif
+
+RAYTRACE_NS_OPEN
+
+/// Compute the nearest intersection of ray \p i_ray with a sphere, within the exclusive magnitude range
+/// \p i_magnitudeRange.
+///
+/// \param i_center The center of the sphere.
+/// \param i_radius The radius of the sphere.
+/// \param i_ray The ray.
+/// \param i_magnitudeRange The range of accepted ray magnitudes.
+/// \param o_magnitude The ray magnitude of the nearest intersection, if any.
+///
+/// \return Whether the ray intersects the sphere within the range.
+inline bool RaySphereNearestHit( const gm::Vec3f&      i_center,
+                                 float                 i_radius,
+                                 const Ray&            i_ray,
+                                 const gm::FloatRange& i_magnitudeRange,
+                                 float&                o_magnitude )
+{
+    const gm::Vec3f originDiff = i_ray.Origin() - i_center;
+    const float     a          = gm::DotProduct( i_ray.Direction(), i_ray.Direction() );
+    const float     halfB      = gm::DotProduct( i_ray.Direction(), originDiff );
+    const float     c          = gm::DotProduct( originDiff, originDiff ) - i_radius * i_radius;
+
+    const float discriminant = halfB * halfB - a * c;
+    if ( discriminant < 0.0f )
+    {
+        return false;
+    }
+
+    // Prefer the nearer root, falling back to the farther root (for example, if the ray origin is inside).
+    const float discriminantSqrt = std::sqrt( discriminant );
+    float       magnitude        = ( -halfB - discriminantSqrt ) / a;
+    if ( magnitude <= i_magnitudeRange.Min() || magnitude >= i_magnitudeRange.Max() )
+    {
+        magnitude = ( -halfB + discriminantSqrt ) / a;
+        if ( magnitude <= i_magnitudeRange.Min() || magnitude >= i_magnitudeRange.Max() )
+        {
+            return false;
+        }
+    }
+
+    o_magnitude = magnitude;
+    return true;
+}
+
+/// Find the nearest sphere in \p i_spheres intersected by \p i_ray, one sphere at a time.
+///
+/// \param i_spheres The spheres to test.
+/// \param i_ray The ray.
+/// \param i_magnitudeRange The range of accepted ray magnitudes.
+/// \param o_magnitude The ray magnitude of the nearest intersection, if any.
+///
+/// \return The index of the nearest sphere intersected, or -1 if there is no intersection.
+inline int FindNearestSphereHitScalar( const SphereArrays&   i_spheres,
+                                       const Ray&            i_ray,
+                                       const gm::FloatRange& i_magnitudeRange,
+                                       float&                o_magnitude )
+{
+    int   nearestIndex     = -1;
+    float nearestMagnitude = i_magnitudeRange.Max();
+    for ( size_t sphereIndex = 0; sphereIndex < i_spheres.Size(); ++sphereIndex )
+    {
+        float magnitude;
+        if ( RaySphereNearestHit( i_spheres.Center( sphereIndex ),
+                                  i_spheres.Radius( sphereIndex ),
+                                  i_ray,
+                                  gm::FloatRange( i_magnitudeRange.Min(), nearestMagnitude ),
+                                  magnitude ) )
+        {
+            nearestIndex     = static_cast< int >( sphereIndex );
+            nearestMagnitude = magnitude;
+        }
+    }
+
+    o_magnitude = nearestMagnitude;
+    return nearestIndex;
+}
+
+/// \cond PRIVATE
+// Reduce per-lane nearest magnitudes & indices into a single nearest hit.
+// Ties are resolved towards the lower sphere index, to match the scalar kernel.
+inline int _ReduceNearestLanes( const float* i_magnitudes, const int* i_indices, int i_laneCount, float& o_magnitude )
+{
+    int nearestIndex = -1;
+    for ( int lane = 0; lane < i_laneCount; ++lane )
+    {
+        if ( i_indices[ lane ] < 0 )
+        {
+            continue;
+        }
+
+        if ( nearestIndex < 0 || i_magnitudes[ lane ] < o_magnitude ||
+             ( i_magnitudes[ lane ] == o_magnitude && i_indices[ lane ] < nearestIndex ) )
+        {
+            nearestIndex = i_indices[ lane ];
+            o_magnitude  = i_magnitudes[ lane ];
+        }
+    }
+
+    return nearestIndex;
+}
+/// \endcond
+
+#if defined( RAYTRACE_X86 )
+
+/// Find the nearest sphere in \p i_spheres intersected by \p i_ray, 4 spheres at a time using SSE2.
+///
+/// \sa FindNearestSphereHitScalar
+inline int FindNearestSphereHitSSE2( const SphereArrays&   i_spheres,
+                                     const Ray&            i_ray,
+                                     const gm::FloatRange& i_magnitudeRange,
+                                     float&                o_magnitude )
+{
+    const __m128 originX    = _mm_set1_ps( i_ray.Origin().X() );
+    const __m128 originY    = _mm_set1_ps( i_ray.Origin().Y() );
+    const __m128 originZ    = _mm_set1_ps( i_ray.Origin().Z() );
+    const __m128 directionX = _mm_set1_ps( i_ray.Direction().X() );
+    const __m128 directionY = _mm_set1_ps( i_ray.Direction().Y() );
+    const __m128 directionZ = _mm_set1_ps( i_ray.Direction().Z() );
+
+    const float  a              = gm::DotProduct( i_ray.Direction(), i_ray.Direction() );
+    const __m128 aVec           = _mm_set1_ps( a );
+    const __m128 inverseA       = _mm_set1_ps( 1.0f / a );
+    const __m128 minMagnitude   = _mm_set1_ps( i_magnitudeRange.Min() );
+    const __m128 zero           = _mm_setzero_ps();
+    const __m128 signMask       = _mm_set1_ps( -0.0f );
+    const __m128i sphereCount   = _mm_set1_epi32( static_cast< int >( i_spheres.Size() ) );
+    const __m128i laneIncrement = _mm_set1_epi32( 4 );
+
+    __m128  nearestMagnitude = _mm_set1_ps( i_magnitudeRange.Max() );
+    __m128i nearestIndex     = _mm_set1_epi32( -1 );
+    __m128i laneIndex        = _mm_setr_epi32( 0, 1, 2, 3 );
+
+    // Bitwise select: ( mask & a ) | ( ~mask & b ).
+    auto select = []( __m128 i_mask, __m128 i_a, __m128 i_b ) {
+        return _mm_or_ps( _mm_and_ps( i_mask, i_a ), _mm_andnot_ps( i_mask, i_b ) );
+    };
+
+    for ( size_t sphereIndex = 0; sphereIndex < i_spheres.PaddedSize(); sphereIndex += 4 )
+    {
+        const __m128 originDiffX = _mm_sub_ps( originX, _mm_load_ps( i_spheres.CenterXData() + sphereIndex ) );
+        const __m128 originDiffY = _mm_sub_ps( originY, _mm_load_ps( i_spheres.CenterYData() + sphereIndex ) );
+        const __m128 originDiffZ = _mm_sub_ps( originZ, _mm_load_ps( i_spheres.CenterZData() + sphereIndex ) );
+        const __m128 radius      = _mm_load_ps( i_spheres.RadiusData() + sphereIndex );
+
+        const __m128 halfB = _mm_add_ps( _mm_add_ps( _mm_mul_ps( directionX, originDiffX ),
+                                                     _mm_mul_ps( directionY, originDiffY ) ),
+                                         _mm_mul_ps( directionZ, originDiffZ ) );
+        const __m128 c     = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( originDiffX, originDiffX ),
+                                                             _mm_mul_ps( originDiffY, originDiffY ) ),
+                                                 _mm_mul_ps( originDiffZ, originDiffZ ) ),
+                                     _mm_mul_ps( radius, radius ) );
+
+        const __m128 discriminant     = _mm_sub_ps( _mm_mul_ps( halfB, halfB ), _mm_mul_ps( aVec, c ) );
+        const __m128 discriminantMask = _mm_cmpge_ps( discriminant, zero );
+        const __m128 discriminantSqrt = _mm_sqrt_ps( _mm_max_ps( discriminant, zero ) );
+        const __m128 negativeHalfB    = _mm_xor_ps( halfB, signMask );
+
+        const __m128 nearRoot = _mm_mul_ps( _mm_sub_ps( negativeHalfB, discriminantSqrt ), inverseA );
+        const __m128 farRoot  = _mm_mul_ps( _mm_add_ps( negativeHalfB, discriminantSqrt ), inverseA );
+
+        const __m128 nearMask =
+            _mm_and_ps( _mm_cmpgt_ps( nearRoot, minMagnitude ), _mm_cmplt_ps( nearRoot, nearestMagnitude ) );
+        const __m128 farMask =
+            _mm_and_ps( _mm_cmpgt_ps( farRoot, minMagnitude ), _mm_cmplt_ps( farRoot, nearestMagnitude ) );
+
+        const __m128 validMask = _mm_castsi128_ps( _mm_cmpgt_epi32( sphereCount, laneIndex ) );
+        const __m128 hitMask =
+            _mm_and_ps( _mm_and_ps( discriminantMask, validMask ), _mm_or_ps( nearMask, farMask ) );
+
+        const __m128 magnitude = select( nearMask, nearRoot, farRoot );
+        nearestMagnitude       = select( hitMask, magnitude, nearestMagnitude );
+        nearestIndex           = _mm_castps_si128(
+            select( hitMask, _mm_castsi128_ps( laneIndex ), _mm_castsi128_ps( nearestIndex ) ) );
+
+        laneIndex = _mm_add_epi32( laneIndex, laneIncrement );
+    }
+
+    alignas( 16 ) float magnitudes[ 4 ];
+    alignas( 16 ) int   indices[ 4 ];
+    _mm_store_ps( magnitudes, nearestMagnitude );
+    _mm_store_si128( reinterpret_cast< __m128i* >( indices ), nearestIndex );
+    return _ReduceNearestLanes( magnitudes, indices, 4, o_magnitude );
+}
+
+/// Find the nearest sphere in \p i_spheres intersected by \p i_ray, 8 spheres at a time using AVX2 & FMA.
+///
+/// The executing CPU must support AVX2, see \ref DetectSIMDLevel.
+///
+/// \sa FindNearestSphereHitScalar
+RAYTRACE_TARGET_AVX2 inline int FindNearestSphereHitAVX2( const SphereArrays&   i_spheres,
+                                                          const Ray&            i_ray,
+                                                          const gm::FloatRange& i_magnitudeRange,
+                                                          float&                o_magnitude )
+{
+    const __m256 originX    = _mm256_set1_ps( i_ray.Origin().X() );
+    const __m256 originY    = _mm256_set1_ps( i_ray.Origin().Y() );
+    const __m256 originZ    = _mm256_set1_ps( i_ray.Origin().Z() );
+    const __m256 directionX = _mm256_set1_ps( i_ray.Direction().X() );
+    const __m256 directionY = _mm256_set1_ps( i_ray.Direction().Y() );
+    const __m256 directionZ = _mm256_set1_ps( i_ray.Direction().Z() );
+
+    const float   a             = gm::DotProduct( i_ray.Direction(), i_ray.Direction() );
+    const __m256  aVec          = _mm256_set1_ps( a );
+    const __m256  inverseA      = _mm256_set1_ps( 1.0f / a );
+    const __m256  minMagnitude  = _mm256_set1_ps( i_magnitudeRange.Min() );
+    const __m256  zero          = _mm256_setzero_ps();
+    const __m256  signMask      = _mm256_set1_ps( -0.0f );
+    const __m256i sphereCount   = _mm256_set1_epi32( static_cast< int >( i_spheres.Size() ) );
+    const __m256i laneIncrement = _mm256_set1_epi32( 8 );
+
+    __m256  nearestMagnitude = _mm256_set1_ps( i_magnitudeRange.Max() );
+    __m256i nearestIndex     = _mm256_set1_epi32( -1 );
+    __m256i laneIndex        = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+
+    for ( size_t sphereIndex = 0; sphereIndex < i_spheres.PaddedSize(); sphereIndex += 8 )
+    {
+        const __m256 originDiffX = _mm256_sub_ps( originX, _mm256_load_ps( i_spheres.CenterXData() + sphereIndex ) );
+        const __m256 originDiffY = _mm256_sub_ps( originY, _mm256_load_ps( i_spheres.CenterYData() + sphereIndex ) );
+        const __m256 originDiffZ = _mm256_sub_ps( originZ, _mm256_load_ps( i_spheres.CenterZData() + sphereIndex ) );
+        const __m256 radius      = _mm256_load_ps( i_spheres.RadiusData() + sphereIndex );
+
+        // halfB = D.(O-C), c = (O-C).(O-C) - R^2
+        __m256 halfB = _mm256_mul_ps( directionZ, originDiffZ );
+        halfB        = _mm256_fmadd_ps( directionY, originDiffY, halfB );
+        halfB        = _mm256_fmadd_ps( directionX, originDiffX, halfB );
+        __m256 c     = _mm256_fmsub_ps( originDiffZ, originDiffZ, _mm256_mul_ps( radius, radius ) );
+        c            = _mm256_fmadd_ps( originDiffY, originDiffY, c );
+        c            = _mm256_fmadd_ps( originDiffX, originDiffX, c );
+
+        const __m256 discriminant     = _mm256_fmsub_ps( halfB, halfB, _mm256_mul_ps( aVec, c ) );
+        const __m256 discriminantMask = _mm256_cmp_ps( discriminant, zero, _CMP_GE_OQ );
+        const __m256 discriminantSqrt = _mm256_sqrt_ps( _mm256_max_ps( discriminant, zero ) );
+        const __m256 negativeHalfB    = _mm256_xor_ps( halfB, signMask );
+
+        const __m256 nearRoot = _mm256_mul_ps( _mm256_sub_ps( negativeHalfB, discriminantSqrt ), inverseA );
+        const __m256 farRoot  = _mm256_mul_ps( _mm256_add_ps( negativeHalfB, discriminantSqrt ), inverseA );
+
+        const __m256 nearMask = _mm256_and_ps( _mm256_cmp_ps( nearRoot, minMagnitude, _CMP_GT_OQ ),
+                                               _mm256_cmp_ps( nearRoot, nearestMagnitude, _CMP_LT_OQ ) );
+        const __m256 farMask  = _mm256_and_ps( _mm256_cmp_ps( farRoot, minMagnitude, _CMP_GT_OQ ),
+                                              _mm256_cmp_ps( farRoot, nearestMagnitude, _CMP_LT_OQ ) );
+
+        const __m256 validMask = _mm256_castsi256_ps( _mm256_cmpgt_epi32( sphereCount, laneIndex ) );
+        const __m256 hitMask =
+            _mm256_and_ps( _mm256_and_ps( discriminantMask, validMask ), _mm256_or_ps( nearMask, farMask ) );
+
+        const __m256 magnitude = _mm256_blendv_ps( farRoot, nearRoot, nearMask );
+        nearestMagnitude       = _mm256_blendv_ps( nearestMagnitude, magnitude, hitMask );
+        nearestIndex           = _mm256_castps_si256(
+            _mm256_blendv_ps( _mm256_castsi256_ps( nearestIndex ), _mm256_castsi256_ps( laneIndex ), hitMask ) );
+
+        laneIndex = _mm256_add_epi32( laneIndex, laneIncrement );
+    }
+
+    alignas( 32 ) float magnitudes[ 8 ];
+    alignas( 32 ) int   indices[ 8 ];
+    _mm256_store_ps( magnitudes, nearestMagnitude );
+    _mm256_store_si256( reinterpret_cast< __m256i* >( indices ), nearestIndex );
+    return _ReduceNearestLanes( magnitudes, indices, 8, o_magnitude );
+}
+
+#endif // RAYTRACE_X86
+
+/// \typedef FindNearestSphereHitFn
+///
+/// Signature shared by all the array intersection kernels.
+using FindNearestSphereHitFn = int ( * )( const SphereArrays&, const Ray&, const gm::FloatRange&, float& );
+
+/// Get the array intersection kernel for the SIMD level \p i_simdLevel.
+///
+/// \param i_simdLevel The instruction set level.
+///
+/// \return The kernel function.
+inline FindNearestSphereHitFn GetFindNearestSphereHitFn( SIMDLevel i_simdLevel )
+{
+#if defined( RAYTRACE_X86 )
+    switch ( i_simdLevel )
+    {
+    case SIMDLevel::AVX2:
+        return &FindNearestSphereHitAVX2;
+    case SIMDLevel::SSE2:
+        return &FindNearestSphereHitSSE2;
+    default:
+        break;
+    }
+#endif
+    return &FindNearestSphereHitScalar;
+}
+
+/// Find the nearest sphere in \p i_spheres intersected by \p i_ray, using the widest kernel supported
+/// by the executing CPU.
+///
+/// \param i_spheres The spheres to test.
+/// \param i_ray The ray.
+/// \param i_magnitudeRange The range of accepted ray magnitudes.
+/// \param o_magnitude The ray magnitude of the nearest intersection, if any.
+///
+/// \return The index of the nearest sphere intersected, or -1 if there is no intersection.
+inline int FindNearestSphereHit( const SphereArrays&   i_spheres,
+                                 const Ray&            i_ray,
+                                 const gm::FloatRange& i_magnitudeRange,
+                                 float&                o_magnitude )
+{
+    static const FindNearestSphereHitFn s_kernel = GetFindNearestSphereHitFn( DetectSIMDLevel() );
+    return s_kernel( i_spheres, i_ray, i_magnitudeRange, o_magnitude );
+}
+
+RAYTRACE_NS_CLOSE
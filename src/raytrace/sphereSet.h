@@ -0,0 +1,135 @@
+#pragma once
+
+/// \file raytrace/sphereSet.h
+///
+/// A collection of spheres, stored and intersected as a single scene object.
+
+#include <raytrace/alignedAllocator.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/material.h>
+#include <raytrace/materialTable.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/sceneObject.h>
+#include <raytrace/sphereArrays.h>
+#include <raytrace/sphereIntersection.h>
+
+#include <gm/functions/expand.h>
+#include <gm/functions/rayPosition.h>
+
+#include <cmath>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class SphereSet
+///
+/// SphereSet stores many spheres in structure-of-arrays form: centers, radii, and material indices are each held
+/// in contiguous, aligned arrays.  Materials are de-duplicated into a \ref MaterialTable owned by the set, unless
+/// compiled into the table of an enclosing object.
+///
+/// Rather than a virtual \ref SceneObject::Hit call per sphere, the nearest hit over the whole set is computed in a
+/// single call, streaming through the arrays with the widest available vector kernel (see
+/// \ref FindNearestSphereHit).
+class SphereSet : public SceneObject
+{
+public:
+    /// Construct an empty set.
+    SphereSet() = default;
+
+    /// Not copyable or movable, because its hits reference a material table by address.
+    SphereSet( const SphereSet& )            = delete;
+    SphereSet( SphereSet&& )                 = delete;
+    SphereSet& operator=( const SphereSet& ) = delete;
+    SphereSet& operator=( SphereSet&& )      = delete;
+
+    /// Append a sphere to the set.
+    ///
+    /// \param i_origin The origin of the sphere.
+    /// \param i_radius The radius of the sphere.
+    /// \param i_material Material associated with this sphere.
+    inline void Append( const gm::Vec3f& i_origin, float i_radius, const MaterialSharedPtr& i_material )
+    {
+        m_spheres.Append( i_origin, i_radius );
+        const uint32_t materialIndex = m_materialTable.Add( i_material );
+        if ( materialIndex == m_compiledMaterialIndices.size() )
+        {
+            m_compiledMaterialIndices.push_back( materialIndex );
+        }
+        m_materialIndices.push_back( materialIndex );
+
+        const float     absRadius = std::abs( i_radius );
+        const gm::Vec3f extent( absRadius, absRadius, absRadius );
+        m_bounds = gm::Expand( m_bounds, gm::Vec3fRange( i_origin - extent, i_origin + extent ) );
+    }
+
+    /// Get the number of spheres in the set.
+    inline size_t Size() const
+    {
+        return m_spheres.Size();
+    }
+
+    /// Get the geometry of the spheres.
+    inline const SphereArrays& Spheres() const
+    {
+        return m_spheres;
+    }
+
+    virtual inline bool
+    Hit( const Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        float magnitude;
+        int   sphereIndex = FindNearestSphereHit( m_spheres, i_ray, i_magnitudeRange, magnitude );
+        if ( sphereIndex < 0 )
+        {
+            return false;
+        }
+
+        const gm::Vec3f center        = m_spheres.Center( sphereIndex );
+        const uint32_t  materialIndex = m_materialIndices[ sphereIndex ];
+        o_record.m_position           = gm::RayPosition( i_ray.Origin(), i_ray.Direction(), magnitude );
+        o_record.m_normal             = ( o_record.m_position - center ) / m_spheres.Radius( sphereIndex );
+        o_record.m_magnitude          = magnitude;
+        o_record.m_material           = m_materialTable.Source( materialIndex ).get();
+        o_record.m_materialIndex      = m_compiledMaterialIndices[ materialIndex ];
+        return true;
+    }
+
+    virtual inline gm::Vec3fRange BoundingBox() const override
+    {
+        return m_bounds;
+    }
+
+    /// Re-target the material indices of the hits at \p io_materials.  Spheres must not be appended afterwards.
+    virtual inline void CompileMaterials( MaterialTable& io_materials ) override
+    {
+        for ( uint32_t materialIndex = 0; materialIndex < m_materialTable.Size(); ++materialIndex )
+        {
+            m_compiledMaterialIndices[ materialIndex ] = io_materials.Add( m_materialTable.Source( materialIndex ) );
+        }
+        m_compiledMaterialTable = &io_materials;
+    }
+
+    virtual inline const MaterialTable* Materials() const override
+    {
+        return m_compiledMaterialTable != nullptr ? m_compiledMaterialTable : &m_materialTable;
+    }
+
+private:
+    // Sphere geometry.
+    SphereArrays m_spheres;
+
+    // Per-sphere index into the material table.
+    std::vector< uint32_t, AlignedAllocator< uint32_t > > m_materialIndices;
+
+    // Material table of the set.
+    MaterialTable m_materialTable;
+
+    // The table which the materials have been compiled into, and the index of each material of the set in it.
+    const MaterialTable*    m_compiledMaterialTable = nullptr;
+    std::vector< uint32_t > m_compiledMaterialIndices;
+
+    // Bounds of all the spheres.
+    gm::Vec3fRange m_bounds;
+};
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,106 @@
+#pragma once
+
+/// \file raytrace/tileRenderer.h
+///
+/// Multi-threaded, tile-based render driver.
+///
+/// The image is split into rectangular tiles, which are handed out to a pool of worker threads.
+/// Each worker invokes a per-tile function over the tiles it executes.
+
+#include <raytrace/raytrace.h>
+#include <raytrace/workStealingScheduler.h>
+
+#include <gm/functions/min.h>
+#include <gm/types/vec2i.h>
+#include <gm/types/vec2iRange.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \var c_defaultTileSize
+///
+/// Default width and height of a single tile, in pixels.
+constexpr int c_defaultTileSize = 16;
+
+/// Resolve the number of worker threads to use for rendering.
+///
+/// \param i_requestedThreadCount The requested number of threads.  A non-positive value will
+/// select the number of hardware threads available.
+///
+/// \return The number of threads to use, which is at least 1.
+inline int ResolveThreadCount( int i_requestedThreadCount )
+{
+    if ( i_requestedThreadCount > 0 )
+    {
+        return i_requestedThreadCount;
+    }
+
+    // hardware_concurrency may return 0 if the value is not computable.
+    int hardwareThreadCount = static_cast< int >( std::thread::hardware_concurrency() );
+    return hardwareThreadCount > 0 ? hardwareThreadCount : 1;
+}
+
+/// Split the extent \p i_extent into a collection of tiles, with dimensions of at most \p i_tileSize.
+///
+/// Tiles along the maximum edges of the extent are clipped.
+///
+/// \param i_extent The extent of the image to split.
+/// \param i_tileSize The width and height of each tile.
+///
+/// \return The collection of tiles, in scanline order.
+inline std::vector< gm::Vec2iRange > ComputeImageTiles( const gm::Vec2iRange& i_extent, int i_tileSize )
+{
+    std::vector< gm::Vec2iRange > tiles;
+    for ( int yCoord = i_extent.Min().Y(); yCoord < i_extent.Max().Y(); yCoord += i_tileSize )
+    {
+        for ( int xCoord = i_extent.Min().X(); xCoord < i_extent.Max().X(); xCoord += i_tileSize )
+        {
+            tiles.push_back( gm::Vec2iRange( gm::Vec2i( xCoord, yCoord ),
+                                             gm::Vec2i( gm::Min( xCoord + i_tileSize, i_extent.Max().X() ),
+                                                        gm::Min( yCoord + i_tileSize, i_extent.Max().Y() ) ) ) );
+        }
+    }
+
+    return tiles;
+}
+
+/// Render all the tiles of \p i_extent in parallel, by invoking \p i_tileFunction for each tile.
+///
+/// The extent is split into tiles, which are executed as tasks by \p io_scheduler.  Each worker starts with
+/// a contiguous band of tiles, and steals tiles from other workers once its own band is complete.
+/// This function blocks until every tile has been processed, or the render is cancelled.
+///
+/// \p i_tileFunction will be called concurrently, thus it must be safe to invoke from multiple threads
+/// for different tiles.  It returns whether the tile was completed: once a tile is not, the render is cancelled,
+/// and the tiles which have not started yet are skipped.
+///
+/// \tparam TileFunctionT Callable with the signature bool( const gm::Vec2iRange& ).
+///
+/// \param i_extent The extent of the image to render.
+/// \param i_tileSize The width and height of each tile.
+/// \param io_scheduler The scheduler executing the tiles.  Its statistics are updated for this render.
+/// \param i_tileFunction The function to invoke per-tile.
+///
+/// \return Whether every tile was completed.
+template < typename TileFunctionT >
+inline bool RenderTiles( const gm::Vec2iRange&  i_extent,
+                         int                    i_tileSize,
+                         WorkStealingScheduler& io_scheduler,
+                         const TileFunctionT&   i_tileFunction )
+{
+    const std::vector< gm::Vec2iRange > tiles = ComputeImageTiles( i_extent, i_tileSize );
+    std::atomic< bool >                 cancelled( false );
+    io_scheduler.Run( tiles.size(), [ & ]( size_t i_tileIndex ) {
+        if ( !cancelled && !i_tileFunction( tiles[ i_tileIndex ] ) )
+        {
+            cancelled = true;
+        }
+    } );
+
+    return !cancelled;
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,160 @@
+/// \file raytrace/wavefrontPathTracer.cpp
+
+#include <raytrace/wavefrontPathTracer.h>
+
+#include <gm/types/floatRange.h>
+
+#include <chrono>
+#include <limits>
+
+RAYTRACE_NS_OPEN
+
+/// \typedef Clock
+///
+/// Clock which stage times are measured with.
+using Clock = std::chrono::steady_clock;
+
+/// Compute the seconds elapsed since \p i_begin.
+static double SecondsSince( const Clock::time_point& i_begin )
+{
+    return std::chrono::duration< double >( Clock::now() - i_begin ).count();
+}
+
+WavefrontStatistics& WavefrontStatistics::operator+=( const WavefrontStatistics& i_statistics )
+{
+    m_intersectionCount += i_statistics.m_intersectionCount;
+    m_intersectionSeconds += i_statistics.m_intersectionSeconds;
+    m_sortSeconds += i_statistics.m_sortSeconds;
+    for ( int typeIndex = 0; typeIndex < c_materialTypeCount; ++typeIndex )
+    {
+        m_scatterCounts[ typeIndex ] += i_statistics.m_scatterCounts[ typeIndex ];
+        m_scatterSeconds[ typeIndex ] += i_statistics.m_scatterSeconds[ typeIndex ];
+    }
+
+    return *this;
+}
+
+WavefrontPathTracer::WavefrontPathTracer( const PathTracerSettings& i_settings )
+    : m_settings( i_settings )
+{
+}
+
+void WavefrontPathTracer::Trace( const SceneObject&            i_scene,
+                                 std::vector< WavefrontPath >& io_paths,
+                                 WavefrontStatistics&          io_statistics )
+{
+    // Fix for "Shadow acne" by culling hits which are too near.
+    const gm::FloatRange magnitudeRange( 0.001f, std::numeric_limits< float >::max() );
+
+    const MaterialTable* materials = i_scene.Materials();
+
+    m_activePaths.clear();
+    for ( size_t pathIndex = 0; pathIndex < io_paths.size() && m_settings.m_rayBounceLimit > 0; ++pathIndex )
+    {
+        m_activePaths.push_back( static_cast< uint32_t >( pathIndex ) );
+    }
+
+    while ( !m_activePaths.empty() )
+    {
+        // Intersect every active path.  Escaping paths terminate with the background color.
+        Clock::time_point stageBegin = Clock::now();
+        m_hits.clear();
+        size_t typeCounts[ c_materialTypeCount ] = {};
+        for ( uint32_t pathIndex : m_activePaths )
+        {
+            WavefrontPath& path = io_paths[ pathIndex ];
+
+            _PathHit hit;
+            hit.m_pathIndex = pathIndex;
+            if ( !i_scene.Hit( path.m_ray, magnitudeRange, hit.m_record ) )
+            {
+                gm::Vec3f background = ComputeBackgroundColor( path.m_ray );
+                path.m_color         = gm::Vec3f( path.m_throughput[ 0 ] * background[ 0 ],
+                                          path.m_throughput[ 1 ] * background[ 1 ],
+                                          path.m_throughput[ 2 ] * background[ 2 ] );
+                continue;
+            }
+
+            typeCounts[ static_cast< int >( HitMaterialType( materials, hit.m_record ) ) ]++;
+            m_hits.push_back( hit );
+        }
+        io_statistics.m_intersectionCount += m_activePaths.size();
+        io_statistics.m_intersectionSeconds += SecondsSince( stageBegin );
+
+        // Group the hits by material type, with a counting sort.
+        stageBegin = Clock::now();
+        size_t typeOffsets[ c_materialTypeCount + 1 ] = {};
+        for ( int typeIndex = 0; typeIndex < c_materialTypeCount; ++typeIndex )
+        {
+            typeOffsets[ typeIndex + 1 ] = typeOffsets[ typeIndex ] + typeCounts[ typeIndex ];
+        }
+
+        m_sortedHits.resize( m_hits.size() );
+        {
+            size_t typeCursors[ c_materialTypeCount ];
+            std::copy( typeOffsets, typeOffsets + c_materialTypeCount, typeCursors );
+            for ( const _PathHit& hit : m_hits )
+            {
+                m_sortedHits[ typeCursors[ static_cast< int >( HitMaterialType( materials, hit.m_record ) ) ]++ ] = hit;
+            }
+        }
+        io_statistics.m_sortSeconds += SecondsSince( stageBegin );
+
+        // Scatter each group in turn.  Surviving paths form the next queue.
+        m_activePaths.clear();
+        for ( int typeIndex = 0; typeIndex < c_materialTypeCount; ++typeIndex )
+        {
+            const size_t begin = typeOffsets[ typeIndex ];
+            const size_t end   = typeOffsets[ typeIndex + 1 ];
+            if ( begin == end )
+            {
+                continue;
+            }
+
+            stageBegin = Clock::now();
+            _Scatter( materials, m_sortedHits, begin, end, io_paths );
+            io_statistics.m_scatterCounts[ typeIndex ] += end - begin;
+            io_statistics.m_scatterSeconds[ typeIndex ] += SecondsSince( stageBegin );
+        }
+    }
+}
+
+void WavefrontPathTracer::_Scatter( const MaterialTable*           i_materials,
+                                    const std::vector< _PathHit >& i_hits,
+                                    size_t                         i_begin,
+                                    size_t                         i_end,
+                                    std::vector< WavefrontPath >&  io_paths )
+{
+    for ( size_t hitIndex = i_begin; hitIndex < i_end; ++hitIndex )
+    {
+        const _PathHit& hit  = i_hits[ hitIndex ];
+        WavefrontPath&  path = io_paths[ hit.m_pathIndex ];
+
+        Ray       scatteredRay;
+        gm::Vec3f attenuation;
+        path.m_rng.SetBounce( path.m_bounce );
+        if ( !ScatterHit( i_materials, path.m_ray, hit.m_record, path.m_rng, attenuation, scatteredRay ) )
+        {
+            // Material has completely absorbed the ray, thus the path carries no color.
+            continue;
+        }
+
+        path.m_throughput = gm::Vec3f( path.m_throughput[ 0 ] * attenuation[ 0 ],
+                                       path.m_throughput[ 1 ] * attenuation[ 1 ],
+                                       path.m_throughput[ 2 ] * attenuation[ 2 ] );
+        path.m_ray        = scatteredRay;
+
+        if ( !SurviveRussianRoulette( m_settings, path.m_bounce, path.m_rng, path.m_throughput ) )
+        {
+            continue;
+        }
+
+        // Paths which reach the bounce limit carry no color.
+        if ( ++path.m_bounce <= m_settings.m_rayBounceLimit )
+        {
+            m_activePaths.push_back( hit.m_pathIndex );
+        }
+    }
+}
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,130 @@
+#pragma once
+
+/// \file raytrace/wavefrontPathTracer.h
+///
+/// Wavefront path tracing integrator, which advances a large batch of paths one stage at a time.
+
+#include <raytrace/hitRecord.h>
+#include <raytrace/material.h>
+#include <raytrace/materialTable.h>
+#include <raytrace/pathTracer.h>
+#include <raytrace/randomNumberGenerator.h>
+#include <raytrace/ray.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/types/vec3f.h>
+
+#include <cstdint>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class WavefrontPath
+///
+/// The state of a single path in flight.
+class WavefrontPath
+{
+public:
+    /// Construct a path starting with the camera ray \p i_ray.
+    ///
+    /// \param i_ray The camera ray.
+    /// \param i_rng The random number generator of the pixel sample.
+    inline WavefrontPath( const Ray& i_ray, const RandomNumberGenerator& i_rng )
+        : m_ray( i_ray )
+        , m_rng( i_rng )
+    {
+    }
+
+    /// The ray to intersect next.
+    Ray m_ray;
+
+    /// The random number generator of the pixel sample.
+    RandomNumberGenerator m_rng;
+
+    /// The running product of attenuations.
+    gm::Vec3f m_throughput = gm::Vec3f( 1.0f, 1.0f, 1.0f );
+
+    /// The color carried back by the path, once it has terminated.
+    gm::Vec3f m_color = gm::Vec3f( 0.0f, 0.0f, 0.0f );
+
+    /// The index of the next bounce, starting from 1 for the camera ray.
+    int m_bounce = 1;
+};
+
+/// \class WavefrontStatistics
+///
+/// Time and work accounting of each stage of a \ref WavefrontPathTracer.
+class WavefrontStatistics
+{
+public:
+    /// Accumulate the counters of \p i_statistics.
+    WavefrontStatistics& operator+=( const WavefrontStatistics& i_statistics );
+
+    /// Number of rays tested for scene intersection.
+    size_t m_intersectionCount = 0;
+
+    /// Seconds spent in scene intersection.
+    double m_intersectionSeconds = 0.0;
+
+    /// Seconds spent grouping hits by material type.
+    double m_sortSeconds = 0.0;
+
+    /// Number of hits scattered, per \ref MaterialType.
+    size_t m_scatterCounts[ c_materialTypeCount ] = {};
+
+    /// Seconds spent scattering hits, per \ref MaterialType.
+    double m_scatterSeconds[ c_materialTypeCount ] = {};
+};
+
+/// \class WavefrontPathTracer
+///
+/// Traces a batch of paths breadth-first, rather than one path at a time as \ref TracePath does.
+///
+/// Each iteration intersects every active path with the scene, then groups the hits by \ref MaterialType, and
+/// scatters each group through the material table of the scene.  Each stage thus executes the same code over a
+/// large queue of rays, and every hit of a group takes the same branch of the \ref MaterialRecord dispatch.  Paths
+/// which survive the scatter stage form the queue of the next iteration.
+///
+/// Each path draws from the same random number streams as \ref TracePath, thus the colors are identical.
+class WavefrontPathTracer final
+{
+public:
+    /// Construct an integrator.
+    ///
+    /// \param i_settings Path construction parameters.
+    explicit WavefrontPathTracer( const PathTracerSettings& i_settings );
+
+    /// Trace the paths \p io_paths through \p i_scene until they have all terminated.  The color of each path is
+    /// written into \ref WavefrontPath::m_color.
+    ///
+    /// \param i_scene The scene to trace against.
+    /// \param io_paths The paths to trace.
+    /// \param io_statistics Counters to accumulate into.
+    void
+    Trace( const SceneObject& i_scene, std::vector< WavefrontPath >& io_paths, WavefrontStatistics& io_statistics );
+
+private:
+    // A path whose ray hit a surface, pending its scatter.
+    struct _PathHit
+    {
+        uint32_t  m_pathIndex;
+        HitRecord m_record;
+    };
+
+    // Scatter the hits of a single material type, appending surviving paths to m_activePaths.
+    void _Scatter( const MaterialTable*           i_materials,
+                   const std::vector< _PathHit >& i_hits,
+                   size_t                         i_begin,
+                   size_t                         i_end,
+                   std::vector< WavefrontPath >&  io_paths );
+
+    PathTracerSettings m_settings;
+
+    // Queues reused across iterations & calls.
+    std::vector< uint32_t > m_activePaths;
+    std::vector< _PathHit > m_hits;
+    std::vector< _PathHit > m_sortedHits;
+};
+
+RAYTRACE_NS_CLOSE
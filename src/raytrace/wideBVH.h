@@ -0,0 +1,506 @@
+#pragma once
+
+/// \file raytrace/wideBVH.h
+///
+/// Wide bounding volume hierarchy, with 4 or 8 children per node tested at once with vector instructions.
+
+#include <raytrace/alignedAllocator.h>
+#include <raytrace/bvh.h>
+#include <raytrace/cpuFeatures.h>
+#include <raytrace/hitRecord.h>
+#include <raytrace/materialTable.h>
+#include <raytrace/raytrace.h>
+#include <raytrace/sceneObject.h>
+
+#include <gm/types/floatRange.h>
+#include <gm/types/vec3fRange.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <vector>
+
+#if defined( RAYTRACE_X86 )
+#include <immintrin.h>
+#endif
+
+RAYTRACE_NS_OPEN
+
+/// \class WideBVH
+///
+/// A bounding volume hierarchy whose nodes have up to \p Width children.  The bounding boxes of the children are
+/// stored within the parent node in structure-of-arrays form, such that a ray is tested against all of them with
+/// a single vectorized slab test.  Intersected children are then visited nearest-first, and children entered
+/// beyond the nearest hit found thus far are pruned.
+///
+/// The hierarchy is built by collapsing a binary, SAH split \ref BVH.  Starting from the two children of a binary
+/// node, the interior child with the largest surface area is repeatedly replaced by its own two children, until
+/// the wide node is full or only leaves remain.
+///
+/// \tparam Width The maximum number of children per node: 4 or 8.
+template < int Width >
+class WideBVH : public SceneObject
+{
+    static_assert( Width == 4 || Width == 8, "WideBVH nodes have either 4 or 8 children." );
+
+public:
+    /// \class Node
+    ///
+    /// A node in the hierarchy, holding the bounding boxes and references of its children.
+    /// Nodes are stored in depth-first order.
+    class alignas( c_simdAlignment ) Node
+    {
+    public:
+        inline Node()
+        {
+            for ( int lane = 0; lane < Width; ++lane )
+            {
+                // An empty box, which no ray intersects.
+                m_minX[ lane ] = m_minY[ lane ] = m_minZ[ lane ] = std::numeric_limits< float >::max();
+                m_maxX[ lane ] = m_maxY[ lane ] = m_maxZ[ lane ] = -std::numeric_limits< float >::max();
+                m_children[ lane ]     = 0;
+                m_objectCounts[ lane ] = 0;
+            }
+        }
+
+        /// Minimum corners of the child bounding boxes, per-axis.
+        float m_minX[ Width ];
+        float m_minY[ Width ];
+        float m_minZ[ Width ];
+
+        /// Maximum corners of the child bounding boxes, per-axis.
+        float m_maxX[ Width ];
+        float m_maxY[ Width ];
+        float m_maxZ[ Width ];
+
+        /// For an interior child, the index of its node.
+        /// For a leaf child, the index of its first scene object.
+        int m_children[ Width ];
+
+        /// The number of scene objects in a leaf child.  Zero for interior children.
+        int m_objectCounts[ Width ];
+
+        /// The number of occupied child slots, which come first.
+        int m_childCount = 0;
+    };
+
+    /// Build a wide BVH over the scene objects \p i_sceneObjects.
+    ///
+    /// \param i_sceneObjects The scene objects to take ownership of.
+    /// \param i_settings The build settings of the binary hierarchy which is collapsed.
+    inline explicit WideBVH( SceneObjectPtrs&& i_sceneObjects, const BVHBuildSettings& i_settings = BVHBuildSettings() )
+    {
+        using Clock = std::chrono::steady_clock;
+
+        BVH binaryBVH( std::move( i_sceneObjects ), i_settings );
+        m_buildStatistics = binaryBVH.BuildStatistics();
+        if ( binaryBVH.Nodes().empty() )
+        {
+            return;
+        }
+
+        const Clock::time_point collapseBegin = Clock::now();
+
+        m_bounds = binaryBVH.BoundingBox();
+        m_nodes.reserve( binaryBVH.Nodes().size() );
+        _Collapse( binaryBVH.Nodes(), 0 );
+
+        // The leaves reference the scene objects in the order of the binary hierarchy.
+        m_sceneObjects = binaryBVH.ReleaseSceneObjects();
+
+        m_buildStatistics.m_buildSeconds += std::chrono::duration< double >( Clock::now() - collapseBegin ).count();
+        m_buildStatistics.m_nodeCount = m_nodes.size();
+
+        // Re-target the hits from the material table of the binary hierarchy, which is destroyed.
+        CompileMaterials( m_materials );
+    }
+
+    /// Not copyable or movable, because the compiled scene objects address the material table held by value.
+    WideBVH( const WideBVH& )            = delete;
+    WideBVH( WideBVH&& )                 = delete;
+    WideBVH& operator=( const WideBVH& ) = delete;
+    WideBVH& operator=( WideBVH&& )      = delete;
+
+    virtual inline bool
+    Hit( const Ray& i_ray, const gm::FloatRange& i_magnitudeRange, HitRecord& o_record ) const override
+    {
+        if ( m_nodes.empty() )
+        {
+            return false;
+        }
+
+        static const _IntersectChildrenFn s_intersectChildren = _GetIntersectChildrenFn( DetectSIMDLevel() );
+
+        _RayData ray;
+        for ( int axis = 0; axis < 3; ++axis )
+        {
+            ray.m_origin[ axis ]           = i_ray.Origin()[ axis ];
+            ray.m_inverseDirection[ axis ] = 1.0f / i_ray.Direction()[ axis ];
+        }
+
+        bool  objectHit           = false;
+        float nearestHitMagnitude = i_magnitudeRange.Max();
+
+        // Children pending a visit, sorted such that the nearest is on top.
+        _StackEntry stack[ c_stackSize ];
+        int         stackSize = 0;
+        int         nodeIndex = 0;
+        while ( true )
+        {
+            const Node& node = m_nodes[ nodeIndex ];
+
+            alignas( c_simdAlignment ) float entryMagnitudes[ Width ];
+            const int hitMask =
+                s_intersectChildren( node, ray, i_magnitudeRange.Min(), nearestHitMagnitude, entryMagnitudes );
+
+            // Push the intersected children, ordered farthest to nearest.
+            const int stackBase = stackSize;
+            for ( int lane = 0; lane < node.m_childCount; ++lane )
+            {
+                if ( ( hitMask & ( 1 << lane ) ) == 0 )
+                {
+                    continue;
+                }
+
+                _StackEntry entry;
+                entry.m_child          = node.m_children[ lane ];
+                entry.m_objectCount    = node.m_objectCounts[ lane ];
+                entry.m_entryMagnitude = entryMagnitudes[ lane ];
+
+                int position = stackSize++;
+                for ( ; position > stackBase && stack[ position - 1 ].m_entryMagnitude < entry.m_entryMagnitude;
+                      --position )
+                {
+                    stack[ position ] = stack[ position - 1 ];
+                }
+                stack[ position ] = entry;
+            }
+
+            // Pop children until the next interior node, intersecting leaves along the way.
+            nodeIndex = -1;
+            while ( stackSize > 0 )
+            {
+                const _StackEntry entry = stack[ --stackSize ];
+                if ( entry.m_entryMagnitude >= nearestHitMagnitude )
+                {
+                    // The child was entered beyond a hit found since it was pushed.
+                    continue;
+                }
+
+                if ( entry.m_objectCount == 0 )
+                {
+                    nodeIndex = entry.m_child;
+                    break;
+                }
+
+                for ( int objectIndex = entry.m_child; objectIndex < entry.m_child + entry.m_objectCount;
+                      ++objectIndex )
+                {
+                    if ( m_sceneObjects[ objectIndex ]->Hit(
+                             i_ray, gm::FloatRange( i_magnitudeRange.Min(), nearestHitMagnitude ), o_record ) )
+                    {
+                        objectHit           = true;
+                        nearestHitMagnitude = o_record.m_magnitude;
+                    }
+                }
+            }
+
+            if ( nodeIndex < 0 )
+            {
+                break;
+            }
+        }
+
+        return objectHit;
+    }
+
+    virtual inline gm::Vec3fRange BoundingBox() const override
+    {
+        return m_bounds;
+    }
+
+    virtual inline void CompileMaterials( MaterialTable& io_materials ) override
+    {
+        for ( const SceneObjectPtr& sceneObject : m_sceneObjects )
+        {
+            sceneObject->CompileMaterials( io_materials );
+        }
+        m_compiledMaterialTable = &io_materials;
+    }
+
+    virtual inline const MaterialTable* Materials() const override
+    {
+        return m_compiledMaterialTable;
+    }
+
+    /// Get the nodes of the hierarchy, in depth-first order.  The first node is the root.
+    ///
+    /// \return The hierarchy nodes.
+    inline const std::vector< Node, AlignedAllocator< Node > >& Nodes() const
+    {
+        return m_nodes;
+    }
+
+    /// Get the scene objects, ordered such that each leaf references a contiguous range.
+    ///
+    /// \return The scene objects.
+    inline const SceneObjectPtrs& SceneObjects() const
+    {
+        return m_sceneObjects;
+    }
+
+    /// Get the build time & quality of the hierarchy.  The build time includes both the binary hierarchy build
+    /// and its collapse, whereas the SAH cost & leaf count are those of the binary hierarchy.
+    ///
+    /// \return The build statistics.
+    inline const BVHBuildStatistics& BuildStatistics() const
+    {
+        return m_buildStatistics;
+    }
+
+private:
+    // Each level of traversal pushes at most Width children, and pops at least one.  The depth is at most that of
+    // the binary hierarchy it was collapsed from.
+    static constexpr int c_stackSize = BVH::c_maxDepth * Width;
+
+    // Ray origin & reciprocal direction, for slab tests.
+    struct _RayData
+    {
+        float m_origin[ 3 ];
+        float m_inverseDirection[ 3 ];
+    };
+
+    // A child pending a visit, with the ray magnitude at which its bounding box is entered.
+    struct _StackEntry
+    {
+        int   m_child;
+        int   m_objectCount;
+        float m_entryMagnitude;
+    };
+
+    // Signature of the slab test kernels.  Tests the ray against the child boxes of a node, within the magnitude
+    // range [i_minMagnitude, i_maxMagnitude].  Writes the entry magnitude of each child, and returns a bit mask of
+    // the intersected children.
+    using _IntersectChildrenFn = int ( * )( const Node&     i_node,
+                                            const _RayData& i_ray,
+                                            float           i_minMagnitude,
+                                            float           i_maxMagnitude,
+                                            float*          o_entryMagnitudes );
+
+    static inline _IntersectChildrenFn _GetIntersectChildrenFn( SIMDLevel i_simdLevel )
+    {
+#if defined( RAYTRACE_X86 )
+        switch ( i_simdLevel )
+        {
+        case SIMDLevel::AVX2:
+            return Width == 8 ? &_IntersectChildrenAVX2 : &_IntersectChildrenSSE2;
+        case SIMDLevel::SSE2:
+            return &_IntersectChildrenSSE2;
+        default:
+            break;
+        }
+#endif
+        return &_IntersectChildrenScalar;
+    }
+
+    static inline int _IntersectChildrenScalar( const Node&     i_node,
+                                                const _RayData& i_ray,
+                                                float           i_minMagnitude,
+                                                float           i_maxMagnitude,
+                                                float*          o_entryMagnitudes )
+    {
+        const float* mins[ 3 ] = { i_node.m_minX, i_node.m_minY, i_node.m_minZ };
+        const float* maxs[ 3 ] = { i_node.m_maxX, i_node.m_maxY, i_node.m_maxZ };
+
+        int hitMask = 0;
+        for ( int lane = 0; lane < i_node.m_childCount; ++lane )
+        {
+            float entryMagnitude = i_minMagnitude;
+            float exitMagnitude  = i_maxMagnitude;
+            for ( int axis = 0; axis < 3; ++axis )
+            {
+                const float t0 = ( mins[ axis ][ lane ] - i_ray.m_origin[ axis ] ) * i_ray.m_inverseDirection[ axis ];
+                const float t1 = ( maxs[ axis ][ lane ] - i_ray.m_origin[ axis ] ) * i_ray.m_inverseDirection[ axis ];
+                entryMagnitude = std::max( entryMagnitude, std::min( t0, t1 ) );
+                exitMagnitude  = std::min( exitMagnitude, std::max( t0, t1 ) );
+            }
+
+            o_entryMagnitudes[ lane ] = entryMagnitude;
+            if ( entryMagnitude <= exitMagnitude )
+            {
+                hitMask |= 1 << lane;
+            }
+        }
+
+        return hitMask;
+    }
+
+#if defined( RAYTRACE_X86 )
+
+    // Slab test of 4 children at a time, using SSE2.
+    static inline int _IntersectChildrenSSE2( const Node&     i_node,
+                                              const _RayData& i_ray,
+                                              float           i_minMagnitude,
+                                              float           i_maxMagnitude,
+                                              float*          o_entryMagnitudes )
+    {
+        const __m128 originX      = _mm_set1_ps( i_ray.m_origin[ 0 ] );
+        const __m128 originY      = _mm_set1_ps( i_ray.m_origin[ 1 ] );
+        const __m128 originZ      = _mm_set1_ps( i_ray.m_origin[ 2 ] );
+        const __m128 inverseX     = _mm_set1_ps( i_ray.m_inverseDirection[ 0 ] );
+        const __m128 inverseY     = _mm_set1_ps( i_ray.m_inverseDirection[ 1 ] );
+        const __m128 inverseZ     = _mm_set1_ps( i_ray.m_inverseDirection[ 2 ] );
+        const __m128 minMagnitude = _mm_set1_ps( i_minMagnitude );
+        const __m128 maxMagnitude = _mm_set1_ps( i_maxMagnitude );
+
+        int hitMask = 0;
+        for ( int lane = 0; lane < Width; lane += 4 )
+        {
+            const __m128 t0X = _mm_mul_ps( _mm_sub_ps( _mm_load_ps( &i_node.m_minX[ lane ] ), originX ), inverseX );
+            const __m128 t1X = _mm_mul_ps( _mm_sub_ps( _mm_load_ps( &i_node.m_maxX[ lane ] ), originX ), inverseX );
+            const __m128 t0Y = _mm_mul_ps( _mm_sub_ps( _mm_load_ps( &i_node.m_minY[ lane ] ), originY ), inverseY );
+            const __m128 t1Y = _mm_mul_ps( _mm_sub_ps( _mm_load_ps( &i_node.m_maxY[ lane ] ), originY ), inverseY );
+            const __m128 t0Z = _mm_mul_ps( _mm_sub_ps( _mm_load_ps( &i_node.m_minZ[ lane ] ), originZ ), inverseZ );
+            const __m128 t1Z = _mm_mul_ps( _mm_sub_ps( _mm_load_ps( &i_node.m_maxZ[ lane ] ), originZ ), inverseZ );
+
+            const __m128 entryMagnitude =
+                _mm_max_ps( _mm_max_ps( _mm_min_ps( t0X, t1X ), _mm_min_ps( t0Y, t1Y ) ),
+                            _mm_max_ps( _mm_min_ps( t0Z, t1Z ), minMagnitude ) );
+            const __m128 exitMagnitude =
+                _mm_min_ps( _mm_min_ps( _mm_max_ps( t0X, t1X ), _mm_max_ps( t0Y, t1Y ) ),
+                            _mm_min_ps( _mm_max_ps( t0Z, t1Z ), maxMagnitude ) );
+
+            _mm_store_ps( o_entryMagnitudes + lane, entryMagnitude );
+            hitMask |= _mm_movemask_ps( _mm_cmple_ps( entryMagnitude, exitMagnitude ) ) << lane;
+        }
+
+        return hitMask & ( ( 1 << i_node.m_childCount ) - 1 );
+    }
+
+    // Slab test of 8 children at a time, using AVX2 & FMA.  The executing CPU must support AVX2.
+    RAYTRACE_TARGET_AVX2 static inline int _IntersectChildrenAVX2( const Node&     i_node,
+                                                                   const _RayData& i_ray,
+                                                                   float           i_minMagnitude,
+                                                                   float           i_maxMagnitude,
+                                                                   float*          o_entryMagnitudes )
+    {
+        // ( box - origin ) * inverseDirection, as a single fused multiply-subtract per plane.
+        const __m256 inverseDirectionX = _mm256_set1_ps( i_ray.m_inverseDirection[ 0 ] );
+        const __m256 inverseDirectionY = _mm256_set1_ps( i_ray.m_inverseDirection[ 1 ] );
+        const __m256 inverseDirectionZ = _mm256_set1_ps( i_ray.m_inverseDirection[ 2 ] );
+        const __m256 scaledOriginX     = _mm256_set1_ps( i_ray.m_origin[ 0 ] * i_ray.m_inverseDirection[ 0 ] );
+        const __m256 scaledOriginY     = _mm256_set1_ps( i_ray.m_origin[ 1 ] * i_ray.m_inverseDirection[ 1 ] );
+        const __m256 scaledOriginZ     = _mm256_set1_ps( i_ray.m_origin[ 2 ] * i_ray.m_inverseDirection[ 2 ] );
+
+        const __m256 t0X = _mm256_fmsub_ps( _mm256_load_ps( i_node.m_minX ), inverseDirectionX, scaledOriginX );
+        const __m256 t1X = _mm256_fmsub_ps( _mm256_load_ps( i_node.m_maxX ), inverseDirectionX, scaledOriginX );
+        const __m256 t0Y = _mm256_fmsub_ps( _mm256_load_ps( i_node.m_minY ), inverseDirectionY, scaledOriginY );
+        const __m256 t1Y = _mm256_fmsub_ps( _mm256_load_ps( i_node.m_maxY ), inverseDirectionY, scaledOriginY );
+        const __m256 t0Z = _mm256_fmsub_ps( _mm256_load_ps( i_node.m_minZ ), inverseDirectionZ, scaledOriginZ );
+        const __m256 t1Z = _mm256_fmsub_ps( _mm256_load_ps( i_node.m_maxZ ), inverseDirectionZ, scaledOriginZ );
+
+        const __m256 entryMagnitude =
+            _mm256_max_ps( _mm256_max_ps( _mm256_min_ps( t0X, t1X ), _mm256_min_ps( t0Y, t1Y ) ),
+                           _mm256_max_ps( _mm256_min_ps( t0Z, t1Z ), _mm256_set1_ps( i_minMagnitude ) ) );
+        const __m256 exitMagnitude =
+            _mm256_min_ps( _mm256_min_ps( _mm256_max_ps( t0X, t1X ), _mm256_max_ps( t0Y, t1Y ) ),
+                           _mm256_min_ps( _mm256_max_ps( t0Z, t1Z ), _mm256_set1_ps( i_maxMagnitude ) ) );
+
+        _mm256_store_ps( o_entryMagnitudes, entryMagnitude );
+        const int hitMask = _mm256_movemask_ps( _mm256_cmp_ps( entryMagnitude, exitMagnitude, _CMP_LE_OQ ) );
+        return hitMask & ( ( 1 << i_node.m_childCount ) - 1 );
+    }
+
+#endif // RAYTRACE_X86
+
+    // Recursively collapse the binary node at \p i_binaryNodeIndex, and its descendants, into wide nodes.
+    // Returns the index of the wide node.
+    inline int _Collapse( const std::vector< BVH::Node >& i_binaryNodes, int i_binaryNodeIndex )
+    {
+        // Gather binary descendants as the children of the wide node, opening the largest interior child first.
+        int              children[ Width ];
+        int              childCount = 0;
+        const BVH::Node& binaryNode = i_binaryNodes[ i_binaryNodeIndex ];
+        if ( binaryNode.m_objectCount > 0 )
+        {
+            // The root alone may be a leaf.
+            children[ childCount++ ] = i_binaryNodeIndex;
+        }
+        else
+        {
+            children[ childCount++ ] = i_binaryNodeIndex + 1;
+            children[ childCount++ ] = binaryNode.m_index;
+        }
+
+        while ( childCount < Width )
+        {
+            int   openChild = -1;
+            float openArea  = -1.0f;
+            for ( int child = 0; child < childCount; ++child )
+            {
+                const BVH::Node& childNode = i_binaryNodes[ children[ child ] ];
+                const float      childArea = BVH::SurfaceArea( childNode.m_bounds );
+                if ( childNode.m_objectCount == 0 && childArea > openArea )
+                {
+                    openChild = child;
+                    openArea  = childArea;
+                }
+            }
+
+            if ( openChild < 0 )
+            {
+                break;
+            }
+
+            // Replace the opened child with its two children.
+            const int openNodeIndex  = children[ openChild ];
+            children[ openChild ]    = openNodeIndex + 1;
+            children[ childCount++ ] = i_binaryNodes[ openNodeIndex ].m_index;
+        }
+
+        const int nodeIndex = static_cast< int >( m_nodes.size() );
+        m_nodes.push_back( Node() );
+        m_nodes[ nodeIndex ].m_childCount = childCount;
+        for ( int child = 0; child < childCount; ++child )
+        {
+            const BVH::Node& childNode = i_binaryNodes[ children[ child ] ];
+            int              childIndex = childNode.m_index;
+            if ( childNode.m_objectCount == 0 )
+            {
+                childIndex = _Collapse( i_binaryNodes, children[ child ] );
+            }
+
+            // The recursion above grows the node array, thus the node is referenced after it.
+            Node& node                   = m_nodes[ nodeIndex ];
+            node.m_minX[ child ]         = childNode.m_bounds.Min().X();
+            node.m_minY[ child ]         = childNode.m_bounds.Min().Y();
+            node.m_minZ[ child ]         = childNode.m_bounds.Min().Z();
+            node.m_maxX[ child ]         = childNode.m_bounds.Max().X();
+            node.m_maxY[ child ]         = childNode.m_bounds.Max().Y();
+            node.m_maxZ[ child ]         = childNode.m_bounds.Max().Z();
+            node.m_children[ child ]     = childIndex;
+            node.m_objectCounts[ child ] = childNode.m_objectCount;
+        }
+
+        return nodeIndex;
+    }
+
+    std::vector< Node, AlignedAllocator< Node > > m_nodes;
+    SceneObjectPtrs                               m_sceneObjects;
+    gm::Vec3fRange                                m_bounds;
+    BVHBuildStatistics                            m_buildStatistics;
+    MaterialTable                                 m_materials;
+    const MaterialTable*                          m_compiledMaterialTable = nullptr;
+};
+
+/// \typedef QBVH
+///
+/// A wide BVH with 4 children per node, tested with 128-bit vectors.
+using QBVH = WideBVH< 4 >;
+
+/// \typedef OBVH
+///
+/// A wide BVH with 8 children per node, tested with 256-bit vectors where available.
+using OBVH = WideBVH< 8 >;
+
+RAYTRACE_NS_CLOSE
@@ -0,0 +1,228 @@
+#pragma once
+
+/// \file raytrace/workStealingScheduler.h
+///
+/// Work-stealing task scheduler, for balancing unevenly expensive units of work across threads.
+
+#include <raytrace/alignedAllocator.h>
+#include <raytrace/raytrace.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+RAYTRACE_NS_OPEN
+
+/// \class WorkerStatistics
+///
+/// Time and task accounting of a single worker thread, over a single \ref WorkStealingScheduler::Run.
+class WorkerStatistics
+{
+public:
+    /// Accumulate the counters of \p i_statistics, such as those of another run.
+    inline WorkerStatistics& operator+=( const WorkerStatistics& i_statistics )
+    {
+        m_busySeconds += i_statistics.m_busySeconds;
+        m_idleSeconds += i_statistics.m_idleSeconds;
+        m_tasksExecuted += i_statistics.m_tasksExecuted;
+        m_tasksStolen += i_statistics.m_tasksStolen;
+        return *this;
+    }
+
+    /// Seconds spent executing tasks.
+    double m_busySeconds = 0.0;
+
+    /// Seconds spent without a task to execute, including waiting for other workers to finish.
+    double m_idleSeconds = 0.0;
+
+    /// Number of tasks executed by this worker.
+    size_t m_tasksExecuted = 0;
+
+    /// Number of the executed tasks which were stolen from another worker's queue.
+    size_t m_tasksStolen = 0;
+};
+
+/// \class WorkStealingScheduler
+///
+/// Executes a batch of indexed tasks across a fixed number of worker threads.
+///
+/// Each worker owns a double-ended queue, initially seeded with a contiguous block of tasks.  A worker pops
+/// tasks from the back of its own queue.  Once its queue is exhausted, it steals tasks from the front of
+/// the other workers' queues, such that cheap regions of work do not leave threads idle while expensive
+/// regions are still pending.
+class WorkStealingScheduler final
+{
+public:
+    /// Construct a scheduler with \p i_threadCount workers.
+    ///
+    /// \param i_threadCount The number of worker threads.  Must be at least 1.
+    inline explicit WorkStealingScheduler( int i_threadCount )
+        : m_queues( i_threadCount )
+        , m_workerStatistics( i_threadCount )
+        , m_statistics( i_threadCount )
+    {
+    }
+
+    /// Get the number of worker threads.
+    ///
+    /// \return The worker thread count.
+    inline int ThreadCount() const
+    {
+        return static_cast< int >( m_queues.size() );
+    }
+
+    /// Get the per-worker statistics recorded over the most recent \ref Run.
+    ///
+    /// \return Statistics, indexed by worker.
+    inline const std::vector< WorkerStatistics >& Statistics() const
+    {
+        return m_statistics;
+    }
+
+    /// Execute tasks indexed from 0 to \p i_taskCount, by invoking \p i_taskFunction for each index.
+    ///
+    /// The calling thread participates as the first worker.  This function blocks until all tasks have
+    /// been executed.
+    ///
+    /// \tparam TaskFunctionT Callable with the signature void( size_t ).
+    ///
+    /// \param i_taskCount The number of tasks to execute.
+    /// \param i_taskFunction The function invoked per task index.  It will be called concurrently.
+    template < typename TaskFunctionT >
+    inline void Run( size_t i_taskCount, const TaskFunctionT& i_taskFunction )
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // Seed each worker queue with a contiguous block of tasks.
+        const size_t threadCount = m_queues.size();
+        for ( size_t workerIndex = 0; workerIndex < threadCount; ++workerIndex )
+        {
+            size_t blockBegin = ( i_taskCount * workerIndex ) / threadCount;
+            size_t blockEnd   = ( i_taskCount * ( workerIndex + 1 ) ) / threadCount;
+
+            WorkerQueue& queue = m_queues[ workerIndex ];
+            queue.m_tasks.clear();
+            for ( size_t taskIndex = blockBegin; taskIndex < blockEnd; ++taskIndex )
+            {
+                queue.m_tasks.push_back( taskIndex );
+            }
+
+            m_workerStatistics[ workerIndex ].m_statistics = WorkerStatistics();
+        }
+
+        std::atomic< size_t > remainingTasks( i_taskCount );
+        const Clock::time_point runBegin = Clock::now();
+
+        auto worker = [ & ]( size_t i_workerIndex ) {
+            WorkerStatistics& statistics = m_workerStatistics[ i_workerIndex ].m_statistics;
+            size_t            taskIndex  = 0;
+            while ( remainingTasks.load() > 0 )
+            {
+                bool stolen = false;
+                if ( !_PopBack( i_workerIndex, taskIndex ) )
+                {
+                    if ( !_Steal( i_workerIndex, taskIndex ) )
+                    {
+                        // Another worker is still executing the last of the tasks.
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    stolen = true;
+                }
+
+                const Clock::time_point taskBegin = Clock::now();
+                i_taskFunction( taskIndex );
+                statistics.m_busySeconds += std::chrono::duration< double >( Clock::now() - taskBegin ).count();
+                statistics.m_tasksExecuted++;
+                statistics.m_tasksStolen += stolen ? 1 : 0;
+                remainingTasks--;
+            }
+        };
+
+        std::vector< std::thread > threads;
+        threads.reserve( threadCount - 1 );
+        for ( size_t workerIndex = 1; workerIndex < threadCount; ++workerIndex )
+        {
+            threads.emplace_back( worker, workerIndex );
+        }
+
+        worker( 0 );
+
+        for ( std::thread& thread : threads )
+        {
+            thread.join();
+        }
+
+        // Idle time is the remainder of the wall time of this run.
+        const double runSeconds = std::chrono::duration< double >( Clock::now() - runBegin ).count();
+        for ( size_t workerIndex = 0; workerIndex < threadCount; ++workerIndex )
+        {
+            m_statistics[ workerIndex ]               = m_workerStatistics[ workerIndex ].m_statistics;
+            m_statistics[ workerIndex ].m_idleSeconds = runSeconds - m_statistics[ workerIndex ].m_busySeconds;
+        }
+    }
+
+private:
+    // Double-ended queue of task indices owned by a single worker.
+    struct WorkerQueue
+    {
+        std::mutex           m_mutex;
+        std::deque< size_t > m_tasks;
+    };
+
+    // Statistics of a single worker, padded to a cache line such that the counters updated by each task are not
+    // falsely shared with those of neighbouring workers.
+    struct alignas( c_cacheLineSize ) PaddedWorkerStatistics
+    {
+        WorkerStatistics m_statistics;
+    };
+    using PaddedWorkerStatisticsArray =
+        std::vector< PaddedWorkerStatistics, AlignedAllocator< PaddedWorkerStatistics, c_cacheLineSize > >;
+
+    // Pop a task from the back of the queue owned by \p i_workerIndex.
+    inline bool _PopBack( size_t i_workerIndex, size_t& o_taskIndex )
+    {
+        WorkerQueue&                  queue = m_queues[ i_workerIndex ];
+        std::lock_guard< std::mutex > lock( queue.m_mutex );
+        if ( queue.m_tasks.empty() )
+        {
+            return false;
+        }
+
+        o_taskIndex = queue.m_tasks.back();
+        queue.m_tasks.pop_back();
+        return true;
+    }
+
+    // Steal a task from the front of another worker's queue, visiting victims in round-robin order
+    // starting from the neighbour of \p i_workerIndex.
+    inline bool _Steal( size_t i_workerIndex, size_t& o_taskIndex )
+    {
+        const size_t threadCount = m_queues.size();
+        for ( size_t offset = 1; offset < threadCount; ++offset )
+        {
+            WorkerQueue&                  victim = m_queues[ ( i_workerIndex + offset ) % threadCount ];
+            std::lock_guard< std::mutex > lock( victim.m_mutex );
+            if ( !victim.m_tasks.empty() )
+            {
+                o_taskIndex = victim.m_tasks.front();
+                victim.m_tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    std::vector< WorkerQueue > m_queues;
+
+    // Written by the workers during a run, then gathered into m_statistics.
+    PaddedWorkerStatisticsArray     m_workerStatistics;
+    std::vector< WorkerStatistics > m_statistics;
+};
+
+RAYTRACE_NS_CLOSE